@@ -0,0 +1,150 @@
+'''
+Benchmarks programs transformed by cpp2c against the original programs.
+
+Each program is copied once per variant, transformed to a fixed point in
+place (except for the original), compiled, and run several times. The
+script reports the median run time of each variant relative to the
+original, and checks that every variant prints the same output and exits
+with the same status as the original.
+
+The programs are the files in evaluation/test and the macro-heavy kernels
+in evaluation/benchmark/kernels. Variants are the original program, and
+the program transformed with each of the given --inline modes ("none"
+means transformed without --inline).
+
+USAGE: python3 benchmark.py [--cpp2c PATH] [--cc CC] [--cflags FLAGS] [--runs N] [--inline (none|hint|always)]...
+'''
+
+import argparse
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from dataclasses import dataclass
+from typing import List, Optional
+
+SCRIPT_DIR = os.path.dirname(os.path.realpath(__file__))
+TEST_DIR = os.path.join(SCRIPT_DIR, '..', 'test')
+KERNELS_DIR = os.path.join(SCRIPT_DIR, 'kernels')
+DEFAULT_CPP2C = os.path.join(
+    SCRIPT_DIR, '..', '..', 'implementation', 'build', 'bin', 'cpp2c')
+
+ORIGINAL = 'original'
+
+
+@dataclass
+class Program:
+    # Name to report the program's results under
+    name: str
+    # Directory containing the program's source file and its headers
+    dir: str
+    # The program's source file, relative to dir
+    file: str
+
+
+@dataclass
+class Result:
+    # Median run time in seconds, or None if the variant failed
+    seconds: Optional[float]
+    output: bytes = b''
+    returncode: int = 0
+    error: str = ''
+
+
+def collect_programs() -> List[Program]:
+    programs = []
+    for dir, prefix in [(TEST_DIR, 'test/'), (KERNELS_DIR, 'kernels/')]:
+        for file in sorted(os.listdir(dir)):
+            if file.endswith('.c'):
+                programs.append(Program(prefix + file, dir, file))
+    return programs
+
+
+def run_variant(program: Program, variant: str, work_dir: str,
+                args: argparse.Namespace) -> Result:
+    # Transform a fresh copy of the program, since transformations edit
+    # headers in place as well
+    variant_dir = os.path.join(work_dir, variant)
+    shutil.copytree(program.dir, variant_dir)
+    src = os.path.join(variant_dir, program.file)
+
+    if variant != ORIGINAL:
+        cmd = [args.cpp2c, 'tr', '-i', '-fp']
+        if variant != 'none':
+            cmd.append(f'--inline={variant}')
+        cmd.append(src)
+        cp = subprocess.run(cmd, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE)
+        if cp.returncode != 0:
+            return Result(None, error='transformation failed: ' + cp.stderr.decode(errors='replace'))
+
+    exe = os.path.join(variant_dir, 'a.out')
+    cp = subprocess.run([args.cc, *args.cflags.split(), '-o', exe, src],
+                        stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                        cwd=variant_dir)
+    if cp.returncode != 0:
+        return Result(None, error='compilation failed: ' + cp.stderr.decode(errors='replace'))
+
+    times = []
+    output, returncode = b'', 0
+    for _ in range(args.runs):
+        start = time.perf_counter()
+        cp = subprocess.run([exe], stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, cwd=variant_dir)
+        times.append(time.perf_counter() - start)
+        output, returncode = cp.stdout, cp.returncode
+    return Result(statistics.median(times), output, returncode)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Benchmark cpp2c-transformed programs against the originals')
+    parser.add_argument('--cpp2c', default=DEFAULT_CPP2C,
+                        help='path to the cpp2c wrapper script')
+    parser.add_argument('--cc', default='gcc', help='C compiler to use')
+    parser.add_argument('--cflags', default='-O2 -w',
+                        help='flags to compile every variant with')
+    parser.add_argument('--runs', type=int, default=5,
+                        help='number of times to run each variant')
+    parser.add_argument('--inline', action='append',
+                        choices=['none', 'hint', 'always'],
+                        help='inline mode to transform with; may be repeated')
+    args = parser.parse_args()
+
+    if not os.path.exists(args.cpp2c):
+        print(f'error: cpp2c not found at {args.cpp2c}', file=sys.stderr)
+        return 1
+    args.cpp2c = os.path.realpath(args.cpp2c)
+    variants = [ORIGINAL] + (args.inline or ['none', 'hint', 'always'])
+
+    print('\t'.join(['program', 'variant', 'median seconds',
+                     'relative to original', 'same behavior']))
+    failed = False
+    for program in collect_programs():
+        with tempfile.TemporaryDirectory(prefix='cpp2c-benchmark-') as work_dir:
+            original = None
+            for variant in variants:
+                result = run_variant(program, variant, work_dir, args)
+                if original is None:
+                    original = result
+
+                if result.seconds is None:
+                    failed = True
+                    print(f'{program.name}\t{variant}\t{result.error.strip()}')
+                    continue
+                same = (result.output == original.output and
+                        result.returncode == original.returncode)
+                failed = failed or not same
+                relative = (f'{result.seconds / original.seconds:.3f}'
+                            if original.seconds else '-')
+                print('\t'.join([program.name, variant, f'{result.seconds:.4f}',
+                                 relative, 'yes' if same else 'no']))
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
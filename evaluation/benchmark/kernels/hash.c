@@ -0,0 +1,30 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Bit-manipulation and hash-mixing macros, as found in hash table and
+// checksum code
+
+#define ROTL32(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
+#define GET_BIT(x, i) (((x) >> (i)) & 1u)
+#define SET_BIT(x, i) ((x) | (1u << (i)))
+#define FMIX32(h) ((h) ^ ((h) >> 16))
+#define MIX(h, k) (ROTL32((h) ^ ((k) * 0xcc9e2d51u), 13) * 5u + 0xe6546b64u)
+
+int main(int argc, char const *argv[])
+{
+    uint32_t n = argc > 1 ? (uint32_t)atoi(argv[1]) : 50000000u;
+
+    uint32_t h = 0x9747b28cu;
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        h = MIX(h, i);
+        h = FMIX32(h);
+        if (GET_BIT(h, i & 31u))
+            bits = SET_BIT(bits, i & 31u);
+    }
+
+    printf("%08x %08x\n", h, bits);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Dense matrix multiply with index and arithmetic helper macros in the
+// innermost loop
+
+#define N 192
+#define IDX(i, j, n) ((i) * (n) + (j))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define SQUARE(x) ((x) * (x))
+#define MUL_ADD(acc, x, y) ((acc) + (x) * (y))
+
+static double a[N * N], b[N * N], c[N * N];
+
+int main(int argc, char const *argv[])
+{
+    int reps = argc > 1 ? atoi(argv[1]) : 40;
+
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+        {
+            a[IDX(i, j, N)] = (double)((i * 7 + j * 3) % 17) / 17.0;
+            b[IDX(i, j, N)] = (double)((i * 5 + j * 11) % 13) / 13.0;
+        }
+
+    double checksum = 0.0;
+    for (int r = 0; r < reps; r++)
+    {
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+            {
+                double acc = 0.0;
+                for (int k = 0; k < N; k++)
+                    acc = MUL_ADD(acc, a[IDX(i, k, N)], b[IDX(k, j, N)]);
+                c[IDX(i, j, N)] = acc;
+            }
+        for (int i = 0; i < N * N; i++)
+            checksum += MIN(SQUARE(c[i]), MAX(c[i], 1.0));
+    }
+
+    printf("%.6f\n", checksum);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// 2D five-point stencil over a grid, with accessor and clamping macros
+
+#define W 512
+#define H 512
+#define AT(g, x, y) ((g)[(y) * W + (x)])
+#define CLAMP(v, lo, hi) ((v) < (lo) ? (lo) : (v) > (hi) ? (hi) : (v))
+#define AVG5(c, n, s, e, w) (((c) + (n) + (s) + (e) + (w)) / 5.0f)
+
+static float grid[2][W * H];
+
+int main(int argc, char const *argv[])
+{
+    int steps = argc > 1 ? atoi(argv[1]) : 600;
+
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++)
+            AT(grid[0], x, y) = (float)((x * 31 + y * 17) % 101);
+
+    for (int t = 0; t < steps; t++)
+    {
+        float *src = grid[t % 2];
+        float *dst = grid[(t + 1) % 2];
+        for (int y = 1; y < H - 1; y++)
+            for (int x = 1; x < W - 1; x++)
+                AT(dst, x, y) = CLAMP(AVG5(AT(src, x, y),
+                                           AT(src, x, y - 1),
+                                           AT(src, x, y + 1),
+                                           AT(src, x + 1, y),
+                                           AT(src, x - 1, y)),
+                                      0.0f, 100.0f);
+    }
+
+    double checksum = 0.0;
+    for (int i = 0; i < W * H; i++)
+        checksum += grid[steps % 2][i];
+    printf("%.3f\n", checksum);
+    return 0;
+}
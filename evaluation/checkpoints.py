@@ -0,0 +1,180 @@
+'''
+Checkpoints that let run_evaluation.py resume an interrupted evaluation.
+
+Each program's checkpoint records the results of every stage of its
+evaluation that has completed, so that a resumed evaluation only runs the
+stages that have not. It also keeps copies of the program's tree:
+- The tree right after it was configured, which is reused instead of
+  extracting and configuring the program again as long as its archive and
+  configure script have not changed.
+- The tree after the last completed fixed-point iteration, which is
+  restored before transformation resumes, since an interrupted iteration may
+  have left some files transformed and others not.
+It also keeps the event records cpp2c emitted during each completed stage,
+which cpp2c-summarize computes the program's summary from.
+
+Copies are always restored to the path the program was configured in, since
+its compile_commands.json contains absolute paths.
+'''
+
+import hashlib
+import json
+import os
+import shutil
+from typing import Any, Dict, Optional
+
+CHECKPOINTS_DIR = r'checkpoints/'
+
+
+def sha256_file(path: str) -> str:
+    h = hashlib.sha256()
+    with open(path, 'rb') as fp:
+        for chunk in iter(lambda: fp.read(1 << 20), b''):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def load_json(path: str) -> Optional[Any]:
+    '''Returns the JSON in the given file, or None if it cannot be read'''
+    try:
+        with open(path) as fp:
+            return json.load(fp)
+    except (OSError, ValueError):
+        return None
+
+
+def save_json(path: str, obj: Any) -> None:
+    '''Writes JSON to the given file, so that it is never left half-written'''
+    tmp_path = path + '.tmp'
+    with open(tmp_path, 'w') as fp:
+        json.dump(obj, fp)
+    os.replace(tmp_path, path)
+
+
+def copy_tree(src: str, dst: str) -> None:
+    '''Replaces dst with a copy of src'''
+    tmp_dst = dst.rstrip('/') + '.tmp'
+    shutil.rmtree(tmp_dst, ignore_errors=True)
+    shutil.copytree(src, tmp_dst, symlinks=True)
+    shutil.rmtree(dst, ignore_errors=True)
+    os.rename(tmp_dst, dst)
+
+
+class ProgramCheckpoint:
+    '''
+    The checkpoint of one program's evaluation in one mode (e.g., with or
+    without -tce)
+    '''
+
+    def __init__(self, name: str, mode: str, archive_sha256: str, configure_script: str):
+        self.name = name
+        self.dir = os.path.realpath(os.path.join(CHECKPOINTS_DIR, mode, name))
+        self.path = os.path.join(self.dir, 'checkpoint.json')
+        # The configured tree does not depend on the mode
+        self.configured_tree = os.path.realpath(
+            os.path.join(CHECKPOINTS_DIR, 'configured', name))
+        self.configured_stamp_path = self.configured_tree.rstrip('/') + '.json'
+        self.configured_stamp = {
+            'archive sha256': archive_sha256,
+            'configure script sha256': hashlib.sha256(configure_script.encode()).hexdigest(),
+        }
+        os.makedirs(self.events_dir, exist_ok=True)
+
+        # Discard checkpoints of other versions of the program
+        self.stages: Dict[str, Any] = {}
+        saved = load_json(self.path)
+        if (saved is not None and
+                saved.get('configured stamp') == self.configured_stamp):
+            self.stages = saved['stages']
+
+    def discard(self) -> None:
+        '''Forgets all completed stages'''
+        self.stages = {}
+        self.save()
+        shutil.rmtree(self.events_dir, ignore_errors=True)
+        os.makedirs(self.events_dir)
+
+    def get(self, stage: str) -> Optional[Any]:
+        '''Returns the saved results of the given stage, or None'''
+        return self.stages.get(stage)
+
+    def set(self, stage: str, results: Any) -> None:
+        '''Saves the results of the given stage'''
+        self.stages[stage] = results
+        self.save()
+
+    def save(self) -> None:
+        save_json(self.path, {'configured stamp': self.configured_stamp,
+                              'stages': self.stages})
+
+    @property
+    def header_edits_dir(self) -> str:
+        return os.path.join(self.dir, 'header-edits')
+
+    @property
+    def events_dir(self) -> str:
+        '''
+        The directory of the event records of each completed stage, which
+        cpp2c-summarize reads
+        '''
+        return os.path.join(self.dir, 'events')
+
+    def remove_transform_event_records(self) -> None:
+        for fn in os.listdir(self.events_dir):
+            if fn.startswith('transform-'):
+                path = os.path.join(self.events_dir, fn)
+                # Records of an interrupted run are still split by
+                # translation unit
+                if os.path.isdir(path):
+                    shutil.rmtree(path)
+                else:
+                    os.remove(path)
+
+    def configured_build_time(self) -> Optional[Dict[str, int]]:
+        '''
+        Returns how long it took to configure the saved configured tree, or
+        None if there is no up-to-date configured tree
+        '''
+        stamp = load_json(self.configured_stamp_path)
+        if (stamp is None or
+                stamp.get('stamp') != self.configured_stamp or
+                not os.path.isdir(self.configured_tree)):
+            return None
+        return stamp['build time']
+
+    def save_configured_tree(self, tree: str, build_time: Dict[str, int]) -> None:
+        # Remove the stamp first so that a partially copied tree is never
+        # considered up-to-date
+        if os.path.exists(self.configured_stamp_path):
+            os.remove(self.configured_stamp_path)
+        copy_tree(tree, self.configured_tree)
+        save_json(self.configured_stamp_path,
+                  {'stamp': self.configured_stamp, 'build time': build_time})
+
+    def restore_configured_tree(self, tree: str) -> None:
+        copy_tree(self.configured_tree, tree)
+
+    def iteration_tree(self, iteration: int) -> str:
+        return os.path.join(self.dir, f'iteration-{iteration}')
+
+    def save_iteration_tree(self, tree: str, iteration: int) -> None:
+        '''
+        Saves the tree after the given iteration. The previous iteration's
+        tree is kept until the caller saves a checkpoint referring to this
+        one and calls remove_iteration_trees_before
+        '''
+        copy_tree(tree, self.iteration_tree(iteration))
+
+    def remove_iteration_trees_before(self, iteration: int) -> None:
+        for i in range(iteration):
+            shutil.rmtree(self.iteration_tree(i), ignore_errors=True)
+
+    def restore_iteration_tree(self, tree: str, iteration: int) -> bool:
+        '''
+        Restores the tree after the given iteration.
+        Returns False if it was not saved
+        '''
+        if not os.path.isdir(self.iteration_tree(iteration)):
+            return False
+        copy_tree(self.iteration_tree(iteration), tree)
+        return True
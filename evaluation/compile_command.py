@@ -41,6 +41,11 @@ def cpp2c_command_from_compile_command(
     arguments.insert(1, f'-fplugin={cpp2c_so_path}')
     # Remove the file from the arguments list (last argument)
     file = arguments.pop()
+    # count only runs the preprocessor, so it replaces Clang's main action
+    # with its own plugin instead of passing a command to cpp2c
+    if cpp2c_commands[:1] == ['count']:
+        arguments.extend(['-Xclang', '-plugin', '-Xclang', 'cpp2c-count'])
+        cpp2c_commands = cpp2c_commands[1:]
     # Add Cpp2C transformer options before the file
     for cmd in cpp2c_commands:
         arguments.extend([
@@ -0,0 +1,160 @@
+'''
+Applies the header edits that in-place cpp2c runs with --header-edits=DIR
+recorded to DIR.
+
+Each TU only writes its own main file; edits to every other file are left
+in a record for this script. That way TUs that include the same header can
+be transformed in parallel, and each header is rewritten once.
+
+Edits made by different TUs with the same key (e.g., the declaration of the
+same transformation of the same macro) are emitted once. If their texts
+differ only in the realpaths listed in their CPP2C annotations, then the
+realpaths are unioned.
+
+USAGE: python3 merge_header_edits.py DIR
+'''
+
+import hashlib
+import json
+import os
+import re
+import sys
+from collections import defaultdict
+from typing import Any, DefaultDict, Dict, List, Tuple
+
+ANNOTATION_PATTERN = re.compile(r'annotate\("((?:[^"\\]|\\.)*)"\)')
+REALPATHS_KEY = 'transformed definition realpaths'
+
+
+def unescape_annotation(s: str) -> str:
+    '''Inverse of escape_json in TransformedDeclarationAnnotation.cc'''
+    return re.sub(r'\\(.)', r'\1', s)
+
+
+def escape_annotation(s: str) -> str:
+    return s.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def merge_texts(key: str, texts: List[str]) -> str:
+    '''
+    Merges the texts of edits that have the same key, or raises a
+    ValueError if they conflict
+    '''
+    if all(t == texts[0] for t in texts):
+        return texts[0]
+
+    # The texts may only differ in their annotations' realpaths
+    if any(ANNOTATION_PATTERN.sub('', t) != ANNOTATION_PATTERN.sub('', texts[0])
+           for t in texts):
+        raise ValueError(f'Conflicting edits for {key!r}')
+    annotations = [json.loads(unescape_annotation(m.group(1)))
+                   for t in texts
+                   for m in [ANNOTATION_PATTERN.search(t)] if m]
+    if len(annotations) != len(texts):
+        raise ValueError(f'Conflicting edits for {key!r}')
+    merged = annotations[0]
+    merged[REALPATHS_KEY] = sorted(
+        set(p for a in annotations for p in a.get(REALPATHS_KEY, [])))
+    # Dump the annotation the same way nlohmann::json does
+    dumped = json.dumps(merged, separators=(',', ':'),
+                        sort_keys=True, ensure_ascii=False)
+    return ANNOTATION_PATTERN.sub(
+        lambda _: f'annotate("{escape_annotation(dumped)}")', texts[0], count=1)
+
+
+def apply_edits(contents: str, edits: List[Dict[str, Any]]) -> str:
+    '''
+    Applies the edits, given in the order they were made, to the contents
+    of a file, ordering edits at the same offset the same way the
+    transformer does
+    '''
+    by_offset: DefaultDict[int, List[Dict[str, Any]]] = defaultdict(list)
+    for e in edits:
+        by_offset[e['offset']].append(e)
+
+    result = []
+    pos = 0
+    for offset in sorted(by_offset):
+        es = by_offset[offset]
+        if offset < pos:
+            raise ValueError(f'Overlapping edits at offset {offset}')
+        lengths = [e['length'] for e in es if e['length'] != 0]
+        if len(set(lengths)) > 1:
+            raise ValueError(f'Overlapping edits at offset {offset}')
+        before = ''.join(e['text'] for e in reversed(es) if e['insert before'])
+        after = ''.join(e['text'] for e in es if not e['insert before'])
+        result.append(contents[pos:offset])
+        result.append(before + after)
+        pos = offset + (lengths[0] if lengths else 0)
+    result.append(contents[pos:])
+    return ''.join(result)
+
+
+def load_records(edits_dir: str) -> List[Dict[str, Any]]:
+    records = []
+    for name in sorted(os.listdir(edits_dir)):
+        if name.endswith('.json'):
+            with open(os.path.join(edits_dir, name)) as fp:
+                records.append(json.load(fp))
+    # Sort by main file so that the merged output doesn't depend on the
+    # order the TUs finished in
+    records.sort(key=lambda r: r['main file'])
+    return records
+
+
+def merge(edits_dir: str) -> None:
+    # Maps each file to its original SHA-1 and its edits from all TUs
+    files: Dict[str, Tuple[str, List[Dict[str, Any]]]] = {}
+    for record in load_records(edits_dir):
+        for f in record['files']:
+            sha1, edits = files.setdefault(f['file'], (f['sha1'], []))
+            if sha1 != f['sha1']:
+                raise ValueError(
+                    f'{f["file"]} was edited by TUs that saw different versions of it')
+            edits.extend(f['edits'])
+
+    for path, (sha1, edits) in sorted(files.items()):
+        # Keep the first edit for each key, with the texts of all of them
+        # merged into it
+        texts: DefaultDict[str, List[str]] = defaultdict(list)
+        unique_edits = []
+        for e in edits:
+            key = e['key'] or json.dumps(
+                [e['offset'], e['length'], e['text']])
+            if key not in texts:
+                unique_edits.append(dict(e, key=key))
+            texts[key].append(e['text'])
+        for e in unique_edits:
+            e['text'] = merge_texts(e['key'], texts[e['key']])
+
+        with open(path, 'rb') as fp:
+            raw = fp.read()
+        if hashlib.sha1(raw).hexdigest() != sha1:
+            raise ValueError(f'{path} changed since it was transformed')
+
+        # Offsets are byte offsets
+        contents = raw.decode('latin-1')
+        new_contents = apply_edits(
+            contents, [dict(e, text=e['text'].encode('utf-8').decode('latin-1'))
+                       for e in unique_edits])
+
+        tmp_path = path + '.cpp2c-tmp'
+        with open(tmp_path, 'wb') as fp:
+            fp.write(new_contents.encode('latin-1'))
+        os.replace(tmp_path, path)
+
+    # The edits have been applied, so they must not be applied again
+    for name in os.listdir(edits_dir):
+        if name.endswith('.json'):
+            os.remove(os.path.join(edits_dir, name))
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip().splitlines()[-1])
+        exit(1)
+    merge(sys.argv[1])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,80 @@
+'''
+Removes the annotations that cpp2c emitted from every translation unit in a
+compile_commands.json.
+
+Translation units are processed in parallel. Each one only writes its own
+main file, and records its removals from headers so that they can be
+applied once all of them are done, with each header rewritten once.
+
+USAGE: python3 remove_annotations.py COMPILE_COMMANDS [--jobs N] [--cpp2c-so PATH]
+'''
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+from typing import Tuple
+
+import compile_command
+import merge_header_edits
+
+SCRIPT_DIR = os.path.dirname(os.path.realpath(__file__))
+DEFAULT_CPP2C_SO = os.path.join(
+    SCRIPT_DIR, '..', 'implementation', 'build', 'lib', 'libCpp2C.so')
+
+
+def remove_annotations(cpp2c_so_path: str,
+                       cc: compile_command.CompileCommand,
+                       edits_dir: str) -> Tuple[str, subprocess.CompletedProcess]:
+    cmd = compile_command.cpp2c_command_from_compile_command(
+        cpp2c_so_path, cc,
+        ['remove_annotations', '-i', f'--header-edits={edits_dir}'])
+    cp = subprocess.run(cmd, shell=True, capture_output=True, text=True,
+                        errors='ignore', cwd=cc.directory)
+    return cc.file, cp
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Remove cpp2c annotations from every translation unit in a project')
+    parser.add_argument('compile_commands',
+                        help='path to the compile_commands.json of the project')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(),
+                        help='number of translation units to process at once')
+    parser.add_argument('--cpp2c-so', default=DEFAULT_CPP2C_SO,
+                        help='path to the cpp2c plugin')
+    args = parser.parse_args()
+
+    cpp2c_so_path = os.path.realpath(args.cpp2c_so)
+    if not os.path.exists(cpp2c_so_path):
+        print(f'error: cpp2c plugin not found at {cpp2c_so_path}', file=sys.stderr)
+        return 1
+    ccs = compile_command.load_compile_commands_from_file(args.compile_commands)
+
+    edits_dir = tempfile.mkdtemp(prefix='cpp2c-header-edits-')
+    failed = False
+    try:
+        with ThreadPoolExecutor(max_workers=args.jobs) as executor:
+            for file, cp in executor.map(
+                    lambda cc: remove_annotations(cpp2c_so_path, cc, edits_dir), ccs):
+                if cp.returncode != 0:
+                    failed = True
+                    print(f'{file}: {cp.stderr.strip()}', file=sys.stderr)
+        # Apply the removals from headers even if some translation units
+        # failed, since their main files have already been written
+        try:
+            merge_header_edits.merge(edits_dir)
+        except ValueError as e:
+            failed = True
+            print(f'Could not merge the removals from headers: {e}', file=sys.stderr)
+    finally:
+        shutil.rmtree(edits_dir, ignore_errors=True)
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,175 +1,366 @@
+import argparse
 import json
 import os
 import shutil
 import subprocess
 import sys
-from collections import defaultdict
-from datetime import datetime
-from operator import itemgetter
-from typing import Any, DefaultDict, Dict, List, Set, Sized
+from concurrent.futures import ProcessPoolExecutor, ThreadPoolExecutor, as_completed
+from contextlib import redirect_stdout
+from dataclasses import dataclass
+from datetime import datetime, timedelta
+from typing import Any, Dict, Iterator, List, Optional, Set, Tuple
 from urllib.request import urlretrieve
-import clang.cindex
-import numpy as np
 
-import abstractometer
+import checkpoints
 import compile_command
-import summaries
-from evaluation_programs import EVALUATION_PROGRAMS
+import merge_header_edits
+from evaluation_programs import EVALUATION_PROGRAMS, EvaluationProgram
 
-MACRO_DEFINITION_PREFIX = 'CPP2C:Macro Definition'
-RAW_MACRO_EXPANSION_PREFIX = 'CPP2C:Raw Macro Expansion'
-POTENTIALLY_TRANSFORMABLE_MACRO_EXPANSION_PREFIX = 'CPP2C:Potentially Transformable Macro Expansion'
-TRANSFORMED_DEFINITION_PREFIX = 'CPP2C:Transformed Definition'
 TRANSFORMED_EXPANSION_PREFIX = 'CPP2C:Transformed Expansion'
-UNTRANSFORMED_EXPANSION_PREFIX = 'CPP2C:Untransformed Expansion'
-
-OLM_TAG = 'object-like'
-FLM_TAG = 'function-like'
+# Precedes each translation unit's messages in event records
+TRANSLATION_UNIT_PREFIX = 'CPP2C:Translation Unit'
+
+
+@dataclass
+class AbstractionMetrics:
+    # The i-th element is the number of top-level expressions of depth i
+    expr_depth_counts: List[int]
+    func_var_names: Set[str]
+    # Maps each function definition and initialized global variable to the
+    # unique symbols it references
+    unique_syms: Dict[str, Set[str]]
+
+    def to_json(self) -> Dict[str, Any]:
+        return {
+            'expr_depth_counts': self.expr_depth_counts,
+            'func_var_names': sorted(self.func_var_names),
+            'unique_syms': {name: sorted(syms) for name, syms in self.unique_syms.items()},
+        }
 
-CATEGORIES_NOT_TRANSFORMED = [
-    'Syntactic well-formedness',
-    'Environment capture',
-    'Parameter side-effects',
-    'Unsupported construct',
-    'Turned off construct'
-]
+    @staticmethod
+    def from_json(j: Dict[str, Any]) -> 'AbstractionMetrics':
+        return AbstractionMetrics(
+            j['expr_depth_counts'],
+            set(j['func_var_names']),
+            {name: set(syms) for name, syms in j['unique_syms'].items()})
 
 
-def is_system_header_path(path: str) -> bool:
+@dataclass
+class TransformationState:
     '''
-    Returns true if this path is:
-    - Blank
-    - A system header path
-    - Scratch space (still not sure what this is)
+    The progress of the fixed-point loop on a program.
+    Checkpointed after each run, so that an interrupted loop can be resumed
+    from the last completed run.
+    What cpp2c did in each run is only kept in the run's event records,
+    which cpp2c-summarize reads
     '''
-    return any((path == '',
-                '/usr/include' in path,
-                '/usr/lib' in path,
-                '<scratch space>' in path))
-
-
-def mhash_dict_len_stat(stat: str, d: Dict[str, Any]):
-    print(f'{stat}: {len(d)}')
-    print(f'    olms: {len([h for h in d if OLM_TAG in h])}')
-    print(f'    flms: {len([h for h in d if FLM_TAG in h])}')
-
-
-def mhash_dict_sum_values_lens_stat(stat: str, d: Dict[str, Sized]):
-    print(f'{stat}: {sum([len(vs) for _, vs in d.items()])}')
-    print(f'    olms: {sum([len(vs) for h, vs in d.items() if OLM_TAG in h])}')
-    print(f'    flms: {sum([len(vs) for h, vs in d.items() if FLM_TAG in h])}')
-
-
-def mhash_dict_sum_values_stat(stat: str, d: Dict[str, int]):
-    print(f'{stat}: {sum([v for _, v in d.items()])}')
-    print(f'    olms: {sum([v for h, v in d.items() if OLM_TAG in h])}')
-    print(f'    flms: {sum([v for h, v in d.items() if FLM_TAG in h])}')
-
-
-def mhash_set_len_stat(stat: str, s: Set[str]):
-    print(f'{stat}: {len(s)}')
-    print(f'    olms: {len([h for h in s if OLM_TAG in h])}')
-    print(f'    flms: {len([h for h in s if FLM_TAG in h])}')
-
+    runs_to_fixed_point: int = 0
+    reached_fixed_point: bool = False
+    # Sum of the times taken by each run
+    time_transforming: timedelta = timedelta()
+
+    def to_json(self) -> Dict[str, Any]:
+        return {
+            'runs_to_fixed_point': self.runs_to_fixed_point,
+            'reached_fixed_point': self.reached_fixed_point,
+            'time_transforming': self.time_transforming.total_seconds(),
+        }
 
-def num_stat(stat: str, i: int):
-    print(f'{stat}: {i}')
+    @staticmethod
+    def from_json(j: Dict[str, Any]) -> 'TransformationState':
+        return TransformationState(
+            j['runs_to_fixed_point'],
+            j['reached_fixed_point'],
+            timedelta(seconds=j['time_transforming']))
 
 
 def str_stat(stat: str, s: str):
     print(f'{stat}: {s}')
 
 
-def top_five_macros_by_val_len(d: Dict[str, Sized]):
-    return sorted(
-        [
-            (mhash.split(';')[0],  # macro name
-             len(vs))  # number of values
-            for mhash, vs in d.items()
-        ],
-        key=itemgetter(1),  # number of values
-        reverse=True  # sort in descending order
-    )[:5]  # select the top five
-
-
-def top_five_macros_by_val(d: Dict[str, int]):
-    return sorted(
-        [
-            (mhash.split(';')[0],  # macro name
-             v)  # value
-            for mhash, v in d.items()
-        ],
-        key=itemgetter(1),  # value
-        reverse=True  # sort in descending order
-    )[:5]  # select the top five
-
-
-def main():
-
-    # Whether to transform macros relying on conditional evaluation
-    tce = len(sys.argv) == 2 and sys.argv[1] == 'tce'
-    results_dir = r'results-tce/' if tce else r'results/'
-
-    # Get the full path to the cpp2c shared object file
-    cpp2c_so_path = r'../implementation/build/lib/libCpp2C.so'
-    if os.path.exists(cpp2c_so_path):
-        cpp2c_so_path = os.path.realpath(cpp2c_so_path)
-    else:
-        print("error: cpp2c.so not found", file=sys.stderr)
-        return 1
+TUResult = Tuple[int, compile_command.CompileCommand, subprocess.CompletedProcess, timedelta]
 
-    # Create the results dir if it does not exist
-    os.makedirs(results_dir, exist_ok=True)
 
-    # Disable numpy text wrapping
-    np.set_printoptions(linewidth=np.inf)
-
-    for evaluation_program in EVALUATION_PROGRAMS:
+def run_cpp2c(cpp2c_so_path: str,
+              compile_commands: List[compile_command.CompileCommand],
+              opts: List[str],
+              jobs: int) -> Iterator[TUResult]:
+    '''
+    Runs cpp2c with the given options on each translation unit, up to jobs
+    at a time. Yields the index of each translation unit, its process, and
+    the time taken as soon as it finishes, so that only the output of the
+    translation units which have not been processed yet is kept in memory
+    '''
+    def run(i: int, cc: compile_command.CompileCommand) -> TUResult:
+        cmd = compile_command.cpp2c_command_from_compile_command(cpp2c_so_path, cc, opts)
+        start_time = datetime.now()
+        # Run the command in the command directory
+        cp = subprocess.run(cmd, shell=True, capture_output=True, text=True,
+                            errors='ignore', cwd=cc.directory)
+        return i, cc, cp, datetime.now() - start_time
+
+    with ThreadPoolExecutor(max_workers=jobs) as executor:
+        # Don't keep references to the futures, so that each one's output
+        # is freed once it has been processed
+        for future in as_completed([executor.submit(run, i, cc) for i, cc in enumerate(compile_commands)]):
+            yield future.result()
+
+
+def abstraction_metrics(cpp2c_so_path: str,
+                        compile_commands: List[compile_command.CompileCommand],
+                        jobs: int) -> Optional[AbstractionMetrics]:
+    '''
+    Computes the abstraction metrics of the given translation units with
+    cpp2c's abstraction_metrics command, and combines them.
+    Returns None if Clang crashed
+    '''
+    metrics = AbstractionMetrics([], set(), {})
+    for _, cc, cp, _ in run_cpp2c(cpp2c_so_path, compile_commands, ['abstraction_metrics'], jobs):
+        if 'PLEASE' in cp.stderr:
+            print(cp.stderr)
+            return None
+        if cp.returncode != 0 or not cp.stdout.strip():
+            print(f'Could not compute abstraction metrics of {cc.file}: {cp.stderr}', file=sys.stderr)
+            continue
+
+        tu_metrics = json.loads(cp.stdout)
+        counts = tu_metrics['expression depth counts']
+        if len(metrics.expr_depth_counts) < len(counts):
+            metrics.expr_depth_counts += [0] * (len(counts) - len(metrics.expr_depth_counts))
+        for depth, count in enumerate(counts):
+            metrics.expr_depth_counts[depth] += count
+        metrics.func_var_names |= set(tu_metrics['function and global names'])
+        metrics.unique_syms.update({name: set(syms) for name, syms in tu_metrics['unique symbols'].items()})
+    return metrics
+
+
+def print_abstraction_metrics(metrics: AbstractionMetrics, prefix: str):
+    num_exprs = sum(metrics.expr_depth_counts)
+    print(f'{prefix}avg expr nesting depth after:',
+          (sum(depth * count for depth, count in enumerate(metrics.expr_depth_counts)) / num_exprs)
+          if num_exprs > 0 else 0)
+    print(f'{prefix}num function and global names:', len(metrics.func_var_names))
+    print(f'{prefix}avg unique symbols per function:',
+          (sum([len(us) for us in metrics.unique_syms.values()])
+           / len(metrics.unique_syms))
+          if len(metrics.unique_syms) > 0 else 0)
+
+
+def record_count_run(results: Iterator[TUResult], events: 'EventRecordWriter') -> bool:
+    '''
+    Records the messages cpp2c emitted while counting the macros of each
+    translation unit.
+    Returns False if Clang crashed
+    '''
+    for i, cc, cp, elapsed_time in results:
+        if 'PLEASE' in cp.stderr:
+            print(cp.stderr)
+            return False
+        events.add(i, cc, cp, elapsed_time)
+    return True
 
-        # Change std out to outfile
-        # FIXME: This is messy, should be using context managers instead
-        ofp_fn = os.path.join(results_dir, evaluation_program.name + '.txt')
-        ofp = open(ofp_fn, 'w')
-        sys.stdout = ofp
 
-        # Download the program zip file if we do not already have it
-        if not os.path.exists(evaluation_program.archive_file):
-            print(f'Downloading {evaluation_program.name} from {evaluation_program.link_to_archive_file}', file=sys.stderr)
+class EventRecordWriter:
+    '''
+    Writes the messages cpp2c emitted for each translation unit of a run in
+    the format cpp2c-summarize reads.
+    Each translation unit's records are written to their own file as soon
+    as it finishes, and are joined in the order of the translation units
+    once all of them are done, so that the summary doesn't depend on the
+    order they finished in, and the records file is never left
+    half-written
+    '''
 
-            # Download the program's archive
-            if evaluation_program.link_to_archive_file.startswith('http'):
-                # http(s) download
-                urlretrieve(evaluation_program.link_to_archive_file, evaluation_program.archive_file)
-            elif evaluation_program.link_to_archive_file.startswith('ftp'):
-                # ftp download
-                # TODO: Use ftp lib instead of relying on wget
-                subprocess.run(f'wget --no-passive {evaluation_program.link_to_archive_file}', shell=True)
+    def __init__(self, path: str, phase: str, run: int):
+        self.path = path
+        self.phase = phase
+        self.run = run
+        self.parts_dir = path + '.parts'
+        shutil.rmtree(self.parts_dir, ignore_errors=True)
+        os.makedirs(self.parts_dir)
+
+    def add(self, i: int, cc: compile_command.CompileCommand,
+            cp: subprocess.CompletedProcess, elapsed_time: timedelta):
+        file_realpath = os.path.join(cc.directory+'/', cc.file)
+        with open(os.path.join(self.parts_dir, f'{i}.txt'), 'w') as fp:
+            fp.write(f'{TRANSLATION_UNIT_PREFIX}\t{self.phase}\t{self.run}\t'
+                     f'{file_realpath}\t{elapsed_time.total_seconds()}\n')
+            fp.write(cp.stderr)
+            if not cp.stderr.endswith('\n'):
+                fp.write('\n')
+
+    def finish(self, num_tus: int):
+        tmp_path = self.path + '.tmp'
+        with open(tmp_path, 'w') as fp:
+            for i in range(num_tus):
+                with open(os.path.join(self.parts_dir, f'{i}.txt')) as part:
+                    shutil.copyfileobj(part, fp)
+        os.replace(tmp_path, self.path)
+        shutil.rmtree(self.parts_dir)
+
+
+def record_transformation_run(results: Iterator[TUResult], events: EventRecordWriter) -> Optional[bool]:
+    '''
+    Records the messages cpp2c emitted while transforming each translation
+    unit in one run of the fixed-point loop.
+    Returns whether any expansions were transformed, or None if Clang crashed
+    '''
+    emitted_a_transformation = False
+    for i, cc, cp, elapsed_time in results:
+        if 'PLEASE' in cp.stderr:
+            print(cp.stderr)
+            return None
+        events.add(i, cc, cp, elapsed_time)
+        emitted_a_transformation = (emitted_a_transformation or
+                                    f'\n{TRANSFORMED_EXPANSION_PREFIX}\t' in '\n' + cp.stderr)
+    return emitted_a_transformation
+
+
+def print_transformation_stats(
+        cpp2c_summarize_path: str,
+        events_dir: str,
+        state: TransformationState) -> bool:
+    '''
+    Prints the macro counts and transformation statistics of an evaluated
+    program, which cpp2c-summarize computes from its event records, with
+    the time the fixed-point loop took.
+    Returns False if the records could not be summarized
+    '''
+    events_paths = ([os.path.join(events_dir, 'count.txt')] +
+                    [os.path.join(events_dir, f'transform-{run}.txt')
+                     for run in range(1, state.runs_to_fixed_point + 1)])
+    missing = [path for path in events_paths if not os.path.exists(path)]
+    if missing:
+        print(f'Event records missing: {missing}; rerun with --restart', file=sys.stderr)
+        return False
+    cp = subprocess.run([cpp2c_summarize_path] + events_paths, capture_output=True, text=True)
+    if cp.returncode != 0:
+        print(f'Could not summarize {events_dir}: {cp.stderr}', file=sys.stderr)
+        return False
+
+    # The wall-clock time isn't in the records, so insert it before the
+    # transformation statistics
+    for line in cp.stdout.splitlines():
+        if line.startswith('runs to reach a fixed point'):
+            str_stat('time to reach a fixed point',
+                     f'{state.time_transforming.seconds}s {state.time_transforming.microseconds}us')
+        print(line)
+    return True
+
+
+def download(evaluation_program: EvaluationProgram):
+    # Download the program zip file if we do not already have it
+    if not os.path.exists(evaluation_program.archive_file):
+        print(f'Downloading {evaluation_program.name} from {evaluation_program.link_to_archive_file}', file=sys.stderr)
+
+        # Download the program's archive
+        if evaluation_program.link_to_archive_file.startswith('http'):
+            # http(s) download
+            urlretrieve(evaluation_program.link_to_archive_file, evaluation_program.archive_file)
+        elif evaluation_program.link_to_archive_file.startswith('ftp'):
+            # ftp download
+            # TODO: Use ftp lib instead of relying on wget
+            subprocess.run(f'wget --no-passive {evaluation_program.link_to_archive_file}', shell=True)
+
+        print(f'Finished downloading {evaluation_program.name}', file=sys.stderr)
+
+
+def configure(evaluation_program: EvaluationProgram, tree: str) -> Dict[str, int]:
+    '''
+    Extracts a fresh copy of the program's archive, configures it, and
+    generates its compile_commands.json. Returns how long it took
+    '''
+    # Delete the old extracted archive
+    shutil.rmtree(tree, ignore_errors=True)
 
-            print(f'Finished downloading {evaluation_program.name}', file=sys.stderr)
+    # Create a fresh extracted archive
+    shutil.unpack_archive(evaluation_program.archive_file, evaluation_program.extract_dir)
 
-        # Delete the old extracted archive
-        shutil.rmtree(evaluation_program.extracted_archive_path, ignore_errors=True)
+    # Configure program and generate compile_commands.json
+    print(f'Building {evaluation_program.name}', file=sys.stderr)
+    build_start_time = datetime.now()
+    subprocess.run(evaluation_program.configure_compile_commands_script, shell=True, capture_output=True, cwd=tree)
+    build_end_time = datetime.now()
+    print(f'Finished building {evaluation_program.name}', file=sys.stderr)
+    build_elapsed_time = build_end_time - build_start_time
+    return {'seconds': build_elapsed_time.seconds, 'microseconds': build_elapsed_time.microseconds}
 
-        # Create a fresh extracted archive
-        shutil.unpack_archive(evaluation_program.archive_file, evaluation_program.extract_dir)
 
-        # Save the current directory so we can move back to it after
-        # evaluating this program
-        evaluation_dir = os.getcwd()
+def evaluate_program(evaluation_program: EvaluationProgram, args: argparse.Namespace) -> bool:
+    '''
+    Evaluates cpp2c on the given program, and writes the results to the
+    program's file in the results directory.
+    Stages that a previous evaluation of the same version of the program
+    completed are not run again; their checkpointed results are printed
+    instead.
+    Returns False if the evaluation did not finish
+    '''
+    # Save the current directory so we can move back to it after
+    # evaluating this program
+    evaluation_dir = os.getcwd()
+    ofp_fn = os.path.join(args.results_dir, evaluation_program.name + '.txt')
+    try:
+        with open(ofp_fn, 'w') as ofp, redirect_stdout(ofp):
+            return evaluate_program_stages(evaluation_program, args)
+    except Exception as e:
+        # Only stop evaluating this program; the completed stages are
+        # checkpointed, so it can be resumed
+        print(f'Error evaluating {evaluation_program.name}: {e!r}', file=sys.stderr)
+        return False
+    finally:
+        # Change back to top-level evaluation directory
+        os.chdir(evaluation_dir)
 
-        print(f'{evaluation_program.name}')
 
-        # Configure program and generate compile_commands.json
-        print(f'Building {evaluation_program.name}', file=sys.stderr)
-        os.chdir(evaluation_program.extracted_archive_path)
-        build_start_time = datetime.now()
-        subprocess.run(evaluation_program.configure_compile_commands_script, shell=True, capture_output=True)
-        build_end_time = datetime.now()
-        print(f'Finished building {evaluation_program.name}', file=sys.stderr)
-        build_elapsed_time = build_end_time - build_start_time
-        str_stat('time to build', f'{build_elapsed_time.seconds}s {build_elapsed_time.microseconds}us')
+def evaluate_program_stages(evaluation_program: EvaluationProgram, args: argparse.Namespace) -> bool:
+    tce = args.mode == 'tce'
+    cpp2c_so_path = args.cpp2c_so_path
+    jobs = args.tu_jobs
+
+    download(evaluation_program)
+
+    checkpoint = checkpoints.ProgramCheckpoint(
+        evaluation_program.name,
+        'tce' if tce else 'default',
+        checkpoints.sha256_file(evaluation_program.archive_file),
+        evaluation_program.configure_compile_commands_script)
+    if args.restart:
+        checkpoint.discard()
+    state = (TransformationState.from_json(checkpoint.get('transformation'))
+             if checkpoint.get('transformation') is not None
+             else TransformationState())
+    finished = checkpoint.get('metrics after') is not None
+
+    print(f'{evaluation_program.name}')
+
+    # Bring the extracted tree to the state the remaining stages start from
+    tree = os.path.realpath(evaluation_program.extracted_archive_path)
+    build_time = checkpoint.configured_build_time()
+    if build_time is None:
+        # Nothing computed from an older configured tree is valid
+        checkpoint.discard()
+        state = TransformationState()
+        finished = False
+        build_time = configure(evaluation_program, tree)
+        checkpoint.save_configured_tree(tree, build_time)
+    elif finished:
+        pass
+    elif state.runs_to_fixed_point > 0:
+        print(f'Resuming {evaluation_program.name} after run {state.runs_to_fixed_point}', file=sys.stderr)
+        if not checkpoint.restore_iteration_tree(tree, state.runs_to_fixed_point):
+            print(f'No tree saved after run {state.runs_to_fixed_point} of {evaluation_program.name}, '
+                  'transforming it from the start', file=sys.stderr)
+            state = TransformationState()
+            checkpoint.restore_configured_tree(tree)
+    else:
+        print(f'Reusing configured tree of {evaluation_program.name}', file=sys.stderr)
+        checkpoint.restore_configured_tree(tree)
+    str_stat('time to build', f'{build_time["seconds"]}s {build_time["microseconds"]}us')
 
+    compile_commands: List[compile_command.CompileCommand] = []
+    if not finished:
         # Collect compile commands from compile_commands.json
+        os.chdir(tree)
         compile_commands = compile_command.load_compile_commands_from_file('compile_commands.json')
         # Only transform .c and .h files that were compiled with a C compiler.
         # We can't transform files compiled with a C++ compiler because
@@ -194,465 +385,260 @@ def main():
                                 cc.file.endswith('.h')) and
                                 ('++' not in cc.arguments[0]) ]
 
-        # Loop 1: Pre-transformation abstraction factor
-        # TODO: Put this into a function so we don't have to repeat this
-        #       code at the end.
-
-        expr_depths: List[int] = []
-        func_var_names: Set[str] = set()
-        unique_syms: Dict[str, Set[str]] = {}
-        for cc in compile_commands:
-            os.chdir(cc.directory)
-            # remove the first and last arguments since they are the compiler
-            # name and the name of the file, and then fix the remaining
-            # arguments
-            args = compile_command.fix_args_for_clang(cc.arguments[1:-1])
-            idx = clang.cindex.Index.create()
-            tu: clang.cindex.TranslationUnit = idx.parse(cc.file, args)
-            c: clang.cindex.Cursor = tu.cursor
-            expr_depths += abstractometer.get_expr_depths(c)
-            func_var_names |= abstractometer.get_func_var_names(c)
-            unique_syms.update(abstractometer.get_unique_decls_refd_in_function_definitions(c))
-            # TODO: test this and check that it actually works
-
-        print('avg expr nesting depth after:', (sum(expr_depths) / len(expr_depths)) if len(expr_depths) > 0 else 0)
-        print('num function and global names:', len(func_var_names))
-        print('avg unique symbols per function:',
-          (sum([len(us) for us in unique_syms])
-           / len(unique_syms))
-          if len(unique_syms) > 0 else 0)
-
-        # Loop 2: Macro metrics
-        # - Count the number of unique macro definitions that are
-        #   defined in the source program itself.
-        # - Count the number of unique invocations in the source program
-        #   of macros defined in the source program.
-        #   + Two invocations are unique if they have different
-        #     spelling locations.
-        # - We accomplish these goals by performing a dry run in which
-        #   we don't make any changes to the program and instead just count
-        #   the number of unique source definitions and invocations found.
-
+    # Loop 1: Pre-transformation abstraction factor
+    if checkpoint.get('metrics before') is None:
+        metrics = abstraction_metrics(cpp2c_so_path, compile_commands, jobs)
+        if metrics is None:
+            return False
+        checkpoint.set('metrics before', metrics.to_json())
+    metrics = AbstractionMetrics.from_json(checkpoint.get('metrics before'))
+    print_abstraction_metrics(metrics, '')
+
+    # Loop 2: Macro metrics
+    # - Count the number of unique macro definitions that are
+    #   defined in the source program itself.
+    # - Count the number of unique invocations in the source program
+    #   of macros defined in the source program.
+    #   + Two invocations are unique if they have different
+    #     spelling locations.
+    # - We accomplish these goals by performing a dry run in which
+    #   we don't make any changes to the program and instead just count
+    #   the number of unique source definitions and invocations found.
+    #   cpp2c count only preprocesses each file, since parsing it isn't
+    #   needed to find them.
+    # - The counts are computed from the dry run's event records by
+    #   cpp2c-summarize, along with the transformation metrics below.
+
+    if checkpoint.get('macro counts') is None:
         print(f'Counting unique macro defs+invks in {evaluation_program.name}', file=sys.stderr)
-
-        source_macro_definitions: Set[str] = set()
-        mhash_to_raw_expansion_spelling_locations: DefaultDict[str, set(str)] = defaultdict(set)
-        for cc in compile_commands:
-            opts = ['tr', '-v'] + (['-tce'] if tce else [])
-            cmd = compile_command.cpp2c_command_from_compile_command(cpp2c_so_path, cc, opts)
-            os.chdir(cc.directory)
-            cp = subprocess.run(cmd, shell=True, capture_output=True, text=True, errors='ignore')
-
-            for line in cp.stderr.splitlines():
-
-                # Check if Clang crashed
-                if 'PLEASE' in line:
-                    print(cp.stderr)
-                    return
-
-                elif line.startswith(MACRO_DEFINITION_PREFIX):
-                    _, mhash, sloc = line.split('\t')
-                    mname, mtype, mdefpath, mnum = mhash.split(';')
-                    # Only record expansions of macros defined in the source program
-                    if not is_system_header_path(mdefpath):
-                        source_macro_definitions.add(mhash)
-
-                elif line.startswith(RAW_MACRO_EXPANSION_PREFIX):
-                    _, mhash, sloc = line.split('\t')
-                    mname, mtype, mdefpath, mnum = mhash.split(';')
-                    # Only record expansions of macros defined in the source program
-                    if not is_system_header_path(mdefpath):
-                        mhash_to_raw_expansion_spelling_locations[mhash].add(sloc)
-
+        events = EventRecordWriter(os.path.join(checkpoint.events_dir, 'count.txt'), 'count', 0)
+        if not record_count_run(run_cpp2c(cpp2c_so_path, compile_commands, ['count'], jobs), events):
+            return False
+        events.finish(len(compile_commands))
+        checkpoint.set('macro counts', {'event records': 'count.txt'})
         print(f'Finished counting unique macro defs+invks in {evaluation_program.name}', file=sys.stderr)
 
-        mhash_dict_len_stat(f'source macro definitions', source_macro_definitions)
-        mhash_dict_len_stat(f'expanded source macro definitions', mhash_to_raw_expansion_spelling_locations)
-
-        # Compute the number of unique raw invocations this way because
-        # (I think) two invocations can have the same spelling location
-        # (e.g. for nested macros which begin with a nested invocation)
-        unique_raw_source_macro_expansions = sum([
-            len(vs) for _, vs in
-            mhash_to_raw_expansion_spelling_locations.items()])
-        num_stat('unique source macro expansions', unique_raw_source_macro_expansions)
-
-        # Loop 3: Macro transformation metrics
-        # - Measure time needed to transform program to a fixed point.
-        # - Measure max time needed to transform each file across all runs.
-        # - Count runs needed to transform program to a fixed point.
-        # - Count potentially transformable definitions.
-        #   + If a macro has a potentially transformable expansion,
-        #     then it is a potentially transformable definition.
-        # - Count potentially transformable invocations.
-        #   + If a unique invocation is of a potentially transformable
-        #     definition, then it is a potentially transformable invocation
-        #   + NOTE:
-        #     I don't think we can expose new expansions by transforming.
-        #     By new, I mean expansions of macros that were not expanded
-        #     in the original program; more expansions of macros that
-        #     were in the original program (e.g., by transforming macros
-        #     with nested invocations) is fine.
-        #     * If we can't, we should create this set by including all
-        #       original invocations of potentially transformable macros.
-        #     * If we can, then I'm not sure how to correctly count this.
-        # - Count transformed macro definitions.
-        #   + Definitions with at least one transformed invocation.
-        # - Count untransformed macro definitions.
-        #   + Definitions with no transformed invocations.
-        # - Hardest one: Unique transformed invocations.
-        #   + The following assumes deduplication during transformation is
-        #     correct, which so far it seems to be.
-        #   + Each transformed macro will have one transformed declaration
-        #     for each of its uniquely typed transformations.
-        #   + Each macro+signature combination will have at most one
-        #     transformed definition in each source file.
-        #     Visually:
-        #
-        #                        definition
-        #                       /
-        #            declaration
-        #           /           \
-        #          /             definition
-        #     macro
-        #          \             definition
-        #           \           /
-        #            declaration
-        #                       \
-        #                        definition
-        #
-        #   + Naively, we could count the number of transformed invocations
-        #     by jut counting the transformed invocation messages
-        #     that Cpp2C emits.
-        #     The problem with this is that a macro may contain
-        #     nested invocations, and one macro may have multiple definitions,
-        #     so if we just count all invocations as unique,
-        #     we could have duplicates.
-        #   + To fix this, we need to only count transformed invocations that
-        #     appear in either:
-        #     a) Source program function definitions.
-        #     b) The first encountered transformed definition of a macro.
-        #   + We will need a way to identify transformed invocations.
-        #   + Idea
-        #     * For each file
-        #       -- For each function definition found in this file
-        #             ++ If this definition is a source definition,
-        #                then count all invocations found in it.
-        #                Otherwise, only count its invocations if the definition
-        #                is a transformed definition of a macro who we have not
-        #                encountered a transformed definition for yet, *and*
-        #                we have not seen this definition before
-        #                in another file.
-        #     * Note: with this approach, the run number in which invocations
-        #       were found is irrelevant.
-        # - Count untransformed macro invocations.
-        #   + Maybe we could count this by looking at the untransformed
-        #     invocation messages that Cpp2C emits, but because
-        #         Potentially transformable invocations
-        #       - Transformed invocations
-        # - Categorize macros by reason(s) they were not transformed.
-        #   + One category for each property and an extra category
-        #     if a macro was not transformed for multiple reasons.
-        # - Count number of polymorphic macro *definitions*.
-        #   + Macros whose set of expansion signatures has a cardinality > 1.
-        # - Count number of polymorphic macro *transformations*.
-        #   + Macros whose set of transformed signatures has a cardinality > 1.
-
-        runs_to_fixed_point = 0
-        program_transform_start_time = datetime.now()
-
-        potentially_transformable_macros: Set[str] = set()
-        potentially_transformable_macros_to_raw_sigs: DefaultDict[str, Set[str]] = defaultdict(set)
-
-        file_realpath_to_max_time_needed_to_transform: Dict[str, datetime.timedelta] = {}
-        file_realpath_to_sum_time_needed_to_transform: Dict[str, datetime.timedelta] = {}
-
-        mhash_to_cats_not_transformed: DefaultDict[str, Set[str]] = defaultdict(set)
-
-        transformed_decl_names: Set[str] = set()
-        transformed_macros: Set[str] = set()
-        mhash_to_transformed_def_to_visit: Dict[str, str] = {}
-        fp_to_fdecl_to_unique_invocation_mhashes: DefaultDict[str, DefaultDict[str, List[str]]] = \
-            defaultdict(lambda: defaultdict(list))
-
-        mhash_to_transformed_types: DefaultDict[str, Set[str]] = defaultdict(set)
-
-        macros_transformed_to_vars: Set[str] = set()
-
+    # Loop 3: Macro transformation metrics
+    # - Measure time needed to transform program to a fixed point.
+    # - Measure max time needed to transform each file across all runs.
+    # - Count runs needed to transform program to a fixed point.
+    # - Count potentially transformable definitions.
+    #   + If a macro has a potentially transformable expansion,
+    #     then it is a potentially transformable definition.
+    # - Count potentially transformable invocations.
+    #   + If a unique invocation is of a potentially transformable
+    #     definition, then it is a potentially transformable invocation
+    #   + NOTE:
+    #     I don't think we can expose new expansions by transforming.
+    #     By new, I mean expansions of macros that were not expanded
+    #     in the original program; more expansions of macros that
+    #     were in the original program (e.g., by transforming macros
+    #     with nested invocations) is fine.
+    #     * If we can't, we should create this set by including all
+    #       original invocations of potentially transformable macros.
+    #     * If we can, then I'm not sure how to correctly count this.
+    # - Count transformed macro definitions.
+    #   + Definitions with at least one transformed invocation.
+    # - Count untransformed macro definitions.
+    #   + Definitions with no transformed invocations.
+    # - Hardest one: Unique transformed invocations.
+    #   + The following assumes deduplication during transformation is
+    #     correct, which so far it seems to be.
+    #   + Each transformed macro will have one transformed declaration
+    #     for each of its uniquely typed transformations.
+    #   + Each macro+signature combination will have at most one
+    #     transformed definition in each source file.
+    #     Visually:
+    #
+    #                        definition
+    #                       /
+    #            declaration
+    #           /           \
+    #          /             definition
+    #     macro
+    #          \             definition
+    #           \           /
+    #            declaration
+    #                       \
+    #                        definition
+    #
+    #   + Naively, we could count the number of transformed invocations
+    #     by jut counting the transformed invocation messages
+    #     that Cpp2C emits.
+    #     The problem with this is that a macro may contain
+    #     nested invocations, and one macro may have multiple definitions,
+    #     so if we just count all invocations as unique,
+    #     we could have duplicates.
+    #   + To fix this, we need to only count transformed invocations that
+    #     appear in either:
+    #     a) Source program function definitions.
+    #     b) The first encountered transformed definition of a macro.
+    #   + We will need a way to identify transformed invocations.
+    #   + Idea
+    #     * For each file
+    #       -- For each function definition found in this file
+    #             ++ If this definition is a source definition,
+    #                then count all invocations found in it.
+    #                Otherwise, only count its invocations if the definition
+    #                is a transformed definition of a macro who we have not
+    #                encountered a transformed definition for yet, *and*
+    #                we have not seen this definition before
+    #                in another file.
+    #     * Note: with this approach, the run number in which invocations
+    #       were found is irrelevant.
+    # - Count untransformed macro invocations.
+    #   + Maybe we could count this by looking at the untransformed
+    #     invocation messages that Cpp2C emits, but because
+    #         Potentially transformable invocations
+    #       - Transformed invocations
+    # - Categorize macros by reason(s) they were not transformed.
+    #   + One category for each property and an extra category
+    #     if a macro was not transformed for multiple reasons.
+    # - Count number of polymorphic macro *definitions*.
+    #   + Macros whose set of expansion signatures has a cardinality > 1.
+    # - Count number of polymorphic macro *transformations*.
+    #   + Macros whose set of transformed signatures has a cardinality > 1.
+    # - Only the wall-clock time and the number of runs are tracked here;
+    #   everything else is computed from each run's event records by
+    #   cpp2c-summarize, so the messages of the runs are never kept in
+    #   memory.
+
+    if not state.reached_fixed_point:
         print(f'Transforming {evaluation_program.name}', file=sys.stderr)
 
+        opts = ['tr', '-dd', '-i', '-v'] + (['-tce'] if tce else [])
+        if args.expansion_budget:
+            opts.append(f'--expansion-budget={args.expansion_budget}')
+        if args.tu_budget:
+            opts.append(f'--tu-budget={args.tu_budget}')
+        # Translation units transformed at the same time may include the
+        # same headers, so only let them write their own main files, and
+        # apply their edits to headers once all of them are done
+        if jobs > 1:
+            shutil.rmtree(checkpoint.header_edits_dir, ignore_errors=True)
+            os.makedirs(checkpoint.header_edits_dir)
+            opts.append(f'--header-edits={checkpoint.header_edits_dir}')
+        # Records of runs that are not being resumed are stale
+        if state.runs_to_fixed_point == 0:
+            checkpoint.remove_transform_event_records()
+
         while True:
-            emitted_a_transformation = False
-            for cc in compile_commands:
-                opts = ['tr', '-dd', '-i', '-v'] + (['-tce'] if tce else [])
-                cmd = compile_command.cpp2c_command_from_compile_command(cpp2c_so_path, cc, opts)
-                # Change to the command directory to run the command
-                os.chdir(cc.directory)
-                file_transform_start_time = datetime.now()
-                cp = subprocess.run(cmd, shell=True, capture_output=True, text=True)
-                file_transform_end_time = datetime.now()
-                file_transform_elapsed_time = file_transform_end_time - file_transform_start_time
-                file_realpath = os.path.join(cc.directory+'/', cc.file)
-                if ((file_realpath not in file_realpath_to_max_time_needed_to_transform) or
-                    (file_realpath_to_max_time_needed_to_transform[file_realpath] < file_transform_elapsed_time)):
-                    file_realpath_to_max_time_needed_to_transform[file_realpath] = file_transform_elapsed_time
-                if file_realpath not in file_realpath_to_sum_time_needed_to_transform:
-                    file_realpath_to_sum_time_needed_to_transform[file_realpath] = file_transform_elapsed_time
-                else:
-                    file_realpath_to_sum_time_needed_to_transform[file_realpath] += file_transform_elapsed_time
-                for line in cp.stderr.splitlines():
-
-                    # Check if Clang crashed
-                    if 'PLEASE' in line:
-                        print(cp.stderr)
-                        return
-
-                    elif line.startswith(POTENTIALLY_TRANSFORMABLE_MACRO_EXPANSION_PREFIX):
-                        _, mhash, raw_sig = line.split('\t')
-                        potentially_transformable_macros.add(mhash)
-                        potentially_transformable_macros_to_raw_sigs[mhash].add(raw_sig)
-
-                    elif line.startswith(TRANSFORMED_EXPANSION_PREFIX):
-                        #  Record that we transformed an expansion this run
-                        emitted_a_transformation = True
-                        _, mhash, transformed_name, containing_function_name, ty, ast_ty = line.split('\t')
-
-                        # If we haven't seen a transformed definition for this macro before,
-                        # then mark the transformed definition this transformed expansion
-                        # references as the one to visit for this macro
-                        if mhash not in mhash_to_transformed_def_to_visit:
-                            mhash_to_transformed_def_to_visit[mhash] = transformed_name
-
-                        # Record that we transformed this macro
-                        transformed_macros.add(mhash)
-
-                        # Add this type to the set of transformed types for this macro
-                        mhash_to_transformed_types[mhash].add(ty)
-
-                        # Record this transformed decl name
-                        transformed_decl_names.add(transformed_name)
-
-                        # Append this macro hash to the list of hashes of transformed expansions found in
-                        # this definition of this function in this file
-                        fp_to_fdecl_to_unique_invocation_mhashes[file_realpath][containing_function_name] += [mhash]
-
-                        # Count the number of macro definitions transformed to variables
-                        macros_transformed_to_vars |= {mhash} if ast_ty == "var" else set()
-
-                    elif line.startswith(UNTRANSFORMED_EXPANSION_PREFIX):
-                        _, mhash, category, reason = line.split('\t')
-                        mhash_to_cats_not_transformed[mhash].add(category)
-
-            runs_to_fixed_point += 1
-            print(f'finished run {runs_to_fixed_point} of {evaluation_program.name}', file=sys.stderr)
-            if not emitted_a_transformation:
+            run_start_time = datetime.now()
+            run = state.runs_to_fixed_point + 1
+            events = EventRecordWriter(os.path.join(checkpoint.events_dir, f'transform-{run}.txt'),
+                                       'transform', run)
+            emitted_a_transformation = record_transformation_run(
+                run_cpp2c(cpp2c_so_path, compile_commands, opts, jobs), events)
+            if emitted_a_transformation is None:
+                return False
+            if jobs > 1:
+                # The translation units may have made edits to the same
+                # header which can't be merged, e.g., if they gave the same
+                # transformation different names. Resuming the program
+                # restores the tree saved after the last completed run
+                try:
+                    merge_header_edits.merge(checkpoint.header_edits_dir)
+                except ValueError as e:
+                    print(f'Could not merge the header edits of run {run} of '
+                          f'{evaluation_program.name}: {e}', file=sys.stderr)
+                    return False
+
+            state.runs_to_fixed_point = run
+            state.time_transforming += datetime.now() - run_start_time
+            state.reached_fixed_point = not emitted_a_transformation
+            events.finish(len(compile_commands))
+            # Save the tree before the checkpoint that refers to it
+            checkpoint.save_iteration_tree(tree, state.runs_to_fixed_point)
+            checkpoint.set('transformation', state.to_json())
+            checkpoint.remove_iteration_trees_before(state.runs_to_fixed_point)
+            print(f'finished run {state.runs_to_fixed_point} of {evaluation_program.name}', file=sys.stderr)
+            if state.reached_fixed_point:
                 break
 
-        program_transform_end_time = datetime.now()
-        program_transform_elapsed_time = program_transform_end_time - program_transform_start_time
-
         print(f'Finished transforming {evaluation_program.name}', file=sys.stderr)
 
-        # Only consider potentially transformable macros which were
-        # never transformed
-        pt_mhash_to_cats_not_transformed = {
-            mhash: cats for mhash, cats in
-            mhash_to_cats_not_transformed.items()
-            if mhash in potentially_transformable_macros and mhash not in transformed_macros
-        }
+    if not print_transformation_stats(args.cpp2c_summarize_path, checkpoint.events_dir, state):
+        return False
 
-        # Only consider expansions of macros Cpp2C said
-        # it could potentially transform
-        mhash_to_potentially_transformable_expansions: Dict[str, set] = {
-            mhash: vs for mhash, vs in
-            mhash_to_raw_expansion_spelling_locations.items()
-            if mhash in potentially_transformable_macros
-        }
+    # Loop 4: Post-transformation abstraction factor
+    # - Compute average depth of top-level expressions.
+    # - Count number of function and global variable names.
+    # - Compute the average number of unique symbols per function.
 
-        str_stat('time to reach a fixed point', f'{program_transform_elapsed_time.seconds}s {program_transform_elapsed_time.microseconds}us')
-        num_stat('runs to reach a fixed point', runs_to_fixed_point)
-        print('max time needed to transform each file')
-        print(json.dumps([
-            (file_realpath, f'{max_elapsed.seconds}s {max_elapsed.microseconds}us')
-            for file_realpath, max_elapsed
-            in file_realpath_to_max_time_needed_to_transform.items()
-        ]))
-        print('sum time needed to transform each file')
-        print(json.dumps([
-            (file_realpath, f'{max_elapsed.seconds}s {max_elapsed.microseconds}us')
-            for file_realpath, max_elapsed
-            in file_realpath_to_sum_time_needed_to_transform.items()
-        ]))
-
-        mhash_set_len_stat('potentially transformable macro definitions', potentially_transformable_macros)
-        mhash_set_len_stat('transformed macro definitions', transformed_macros)
-        mhash_dict_len_stat('untransformed potentially transformable macro definitions',
-                            pt_mhash_to_cats_not_transformed)
-
-        num_stat("number of macros transformed to vars", len(macros_transformed_to_vars))
-        str_stat("percentage increase in transformed macros with our approach",
-                 (str(
-                     ((
-                         len(transformed_macros)
-                         - len(macros_transformed_to_vars))
-                      / len(macros_transformed_to_vars))
-                     * 100)
-                  + '%')
-                 if len(macros_transformed_to_vars) > 0 else 'N/A')
-
-        # For each category, check if the set of categories of reasons
-        # a macro was not transformed is a singleton list containing
-        # only that category.
-        # Also count macros that were not transformed for multiple categories.
-        print('categories of reasons not transformed:')
-        multiple_cats_count = 0
-        for i, cat in enumerate(CATEGORIES_NOT_TRANSFORMED):
-            count = 0
-            for cats in pt_mhash_to_cats_not_transformed.values():
-                if cats == {cat}:
-                    count += 1
-
-                # Only check for multiple cats on the first pass
-                elif i == 0 and len(cats) > 1:
-                    multiple_cats_count += 1
-
-            print(f'    {cat.lower()}: {count}')
-        print(f'    multiple categories: {multiple_cats_count}')
-
-        print('categories of reasons not transformed (flms):')
-        multiple_cats_count = 0
-        for i, cat in enumerate(CATEGORIES_NOT_TRANSFORMED):
-            count = 0
-            for mh, cats in pt_mhash_to_cats_not_transformed.items():
-                if FLM_TAG in mh:
-                    if cats == {cat}:
-                        count += 1
-
-                    # Only check for multiple cats on the first pass
-                    elif i == 0 and len(cats) > 1:
-                        multiple_cats_count += 1
-
-            print(f'    {cat.lower()}: {count}')
-        print(f'    multiple categories: {multiple_cats_count}')
-
-        mhash_dict_sum_values_lens_stat(f'potentially transformable invocations',
-                                        mhash_to_potentially_transformable_expansions)
-
-        mhash_to_unique_transformed_invocations: DefaultDict[str, int] = defaultdict(int)
-        # Count the number of transformed invocations in source func definitions
-        unique_source_transformed_invocations = 0
-        for frealpath, fdecl_to_unique_invocation_mhashes in fp_to_fdecl_to_unique_invocation_mhashes.items():
-            for fdecl, mhashes in fdecl_to_unique_invocation_mhashes.items():
-                if fdecl not in transformed_decl_names:
-                    unique_source_transformed_invocations += len(mhashes)
-                    for mhash in mhashes:
-                        mhash_to_unique_transformed_invocations[mhash] += 1
-
-        num_stat('unique transformed invocations in source definitions', unique_source_transformed_invocations)
-
-        # Count the number of transformed invocations in transformed definitions.
-        # We only consider one file's definition of each canonical def
-        canonical_defs = set(mhash_to_transformed_def_to_visit.values())
-        canonical_defs_already_found_a_def_for: Set[str] = set()
-        unique_transformed_def_transformed_invocations = 0
-
-        # Just for fun: Keep track of which macros had the most transformed immediately nested invocations
-        # canon_def_to_no_nested_invocations = defaultdict(int)
-
-        for frealpath, fdecl_to_unique_invocation_mhashes in fp_to_fdecl_to_unique_invocation_mhashes.items():
-            for fdecl, mhashes in fdecl_to_unique_invocation_mhashes.items():
-                if fdecl in transformed_decl_names and fdecl in canonical_defs:
-                    if fdecl not in canonical_defs_already_found_a_def_for:
-                        unique_transformed_def_transformed_invocations += len(mhashes)
-                        canonical_defs_already_found_a_def_for.add(fdecl)
-                        # canon_def_to_no_nested_invocations[fdecl] += len(mhashes)
-                        for mhash in mhashes:
-                            mhash_to_unique_transformed_invocations[mhash] += 1
-
-        num_stat('unique transformed invocations in transformed definitions',
-                 unique_transformed_def_transformed_invocations)
-
-        total_transformed_invocations = (unique_source_transformed_invocations +
-                                         unique_transformed_def_transformed_invocations)
-
-        # num_stat('total unique transformed invocations', total_transformed_invocations)
-        mhash_dict_sum_values_stat('total unique transformed invocations', mhash_to_unique_transformed_invocations)
-
-        # Which macros had the most transformed invocations?
-        top_five_most_transformed_macros = top_five_macros_by_val(mhash_to_unique_transformed_invocations)
-        print(f'top five most transformed macros: {top_five_most_transformed_macros}')
-
-        potentially_transformable_invocations = sum([
-            len(vs) for _, vs in
-            mhash_to_potentially_transformable_expansions.items()
-        ])
-        untransformed_potentially_transformable_invocations = (potentially_transformable_invocations -
-                                                               total_transformed_invocations)
-        print(
-            f'untransformed invocations: {untransformed_potentially_transformable_invocations}')
-
-        potentially_transformable_poly_macros = {
-            mhash for mhash, tys in
-            potentially_transformable_macros_to_raw_sigs.items()
-            if len(tys) > 1
-        }
+    if checkpoint.get('metrics after') is None:
+        metrics = abstraction_metrics(cpp2c_so_path, compile_commands, jobs)
+        if metrics is None:
+            return False
+        checkpoint.set('metrics after', metrics.to_json())
+        # The transformed tree is the extracted tree now
+        checkpoint.remove_iteration_trees_before(state.runs_to_fixed_point + 1)
+    metrics = AbstractionMetrics.from_json(checkpoint.get('metrics after'))
+    print_abstraction_metrics(metrics, 'transformed ')
 
-        mhash_set_len_stat('potentially transformable polymorphic macros', potentially_transformable_poly_macros)
+    # Flush to see evaluation results of this program before moving on to next one
+    sys.stdout.flush()
+    print()
+    return True
 
-        transformed_poly_macros = {
-            mhash for mhash, tys in
-            mhash_to_transformed_types.items()
-            if len(tys) > 1
-        }
 
-        mhash_set_len_stat('transformed polymorphic macros', transformed_poly_macros)
-
-        transformed_tys_twenty_num = summaries.twenty_num([len(tys) for (tys) in mhash_to_transformed_types.values()])
-
-        print(f'twenty pt summary of transformed types: {transformed_tys_twenty_num}')
-
-        # For fun: Which macros had the most uniquely typed transformations?
-        top_five_poly_macros = top_five_macros_by_val_len(mhash_to_transformed_types)
-        print(f'macros with most transformed types: {top_five_poly_macros}')
-
-        # Loop 4: Post-transformation abstraction factor
-        # - Compute average depth of top-level expressions.
-        # - Count number of function and global variable names.
-        # - Compute the average number of unique symbols per function.
-
-        expr_depths: List[int] = []
-        func_var_names: Set[str] = set()
-        unique_syms: Dict[str, Set[str]] = {}
-        for cc in compile_commands:
-            os.chdir(cc.directory)
-            # remove the first and last arguments since they are the compiler
-            # name and the name of the file, and then fix the remaining
-            # arguments
-            args = compile_command.fix_args_for_clang(cc.arguments[1:-1])
-            idx = clang.cindex.Index.create()
-            tu: clang.cindex.TranslationUnit = idx.parse(cc.file, args)
-            c: clang.cindex.Cursor = tu.cursor
-            expr_depths += abstractometer.get_expr_depths(c)
-            func_var_names |= abstractometer.get_func_var_names(c)
-            unique_syms.update(abstractometer.get_unique_decls_refd_in_function_definitions(c))
-            # TODO: test this and check that it actually works
-
-        print('transformed avg expr nesting depth after:', (sum(expr_depths) / len(expr_depths)) if len(expr_depths) > 0 else 0)
-        print('transformed num function and global names:', len(func_var_names))
-        print('transformed avg unique symbols per function:',
-          (sum([len(us) for us in unique_syms])
-           / len(unique_syms))
-          if len(unique_syms) > 0 else 0)
-
-        # Flush to see evaluation results of this program before moving on to next one
-        sys.stdout.flush()
-        print()
-        # Close out file
-        # FIXME: use context manager instead
-        ofp.close()
-        # Change back to top-level evaluation directory
-        os.chdir(evaluation_dir)
+def main():
+    parser = argparse.ArgumentParser(
+        description='Evaluate cpp2c on the programs in evaluation_programs.py')
+    parser.add_argument('mode', nargs='?', choices=['tce'],
+                        help='transform macros relying on conditional evaluation')
+    parser.add_argument('--jobs', type=int, default=1,
+                        help='maximum number of cpp2c processes to run at once')
+    parser.add_argument('--programs', type=int, default=1,
+                        help='number of programs to evaluate at once; they share the jobs equally')
+    parser.add_argument('--expansion-budget', type=int, default=0, metavar='MS',
+                        help='milliseconds cpp2c may spend analyzing each top-level expansion')
+    parser.add_argument('--tu-budget', type=int, default=0, metavar='MS',
+                        help='milliseconds cpp2c may spend transforming each translation unit')
+    parser.add_argument('--restart', action='store_true',
+                        help='evaluate every program from the start, only reusing configured trees')
+    args = parser.parse_args()
+
+    # Results of evaluations with -tce are kept separately
+    args.results_dir = r'results-tce/' if args.mode == 'tce' else r'results/'
+    args.tu_jobs = max(1, args.jobs // max(1, args.programs))
+
+    # Get the full path to the cpp2c shared object file
+    cpp2c_so_path = r'../implementation/build/lib/libCpp2C.so'
+    if os.path.exists(cpp2c_so_path):
+        args.cpp2c_so_path = os.path.realpath(cpp2c_so_path)
+    else:
+        print("error: cpp2c.so not found", file=sys.stderr)
+        return 1
+
+    # The statistics are computed from the event records by cpp2c-summarize,
+    # which is built along with cpp2c
+    cpp2c_summarize_path = r'../implementation/build/bin/cpp2c-summarize'
+    if os.path.exists(cpp2c_summarize_path):
+        args.cpp2c_summarize_path = os.path.realpath(cpp2c_summarize_path)
+    else:
+        print("error: cpp2c-summarize not found", file=sys.stderr)
+        return 1
+
+    # Create the results dir if it does not exist.
+    # Programs are evaluated in their own trees, so use its full path
+    os.makedirs(args.results_dir, exist_ok=True)
+    args.results_dir = os.path.realpath(args.results_dir)
+
+    # Each program is evaluated in its own process, since evaluating a
+    # program changes the working directory and redirects stdout
+    if args.programs > 1:
+        with ProcessPoolExecutor(max_workers=args.programs) as executor:
+            finished = list(executor.map(
+                evaluate_program, EVALUATION_PROGRAMS, [args] * len(EVALUATION_PROGRAMS)))
+    else:
+        finished = [evaluate_program(p, args) for p in EVALUATION_PROGRAMS]
+
+    for evaluation_program, program_finished in zip(EVALUATION_PROGRAMS, finished):
+        if not program_finished:
+            print(f'Evaluation of {evaluation_program.name} did not finish; '
+                  'rerun to resume it', file=sys.stderr)
+    return 0 if all(finished) else 1
 
 
 if __name__ == '__main__':
-    main()
+    sys.exit(main())
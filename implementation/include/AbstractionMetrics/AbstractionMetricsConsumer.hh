@@ -0,0 +1,14 @@
+#pragma once
+
+#include "clang/AST/ASTConsumer.h"
+
+namespace AbstractionMetrics
+{
+    // AST consumer which prints the abstraction metrics of a translation
+    // unit as JSON
+    class AbstractionMetricsConsumer : public clang::ASTConsumer
+    {
+    public:
+        virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
+    };
+} // namespace AbstractionMetrics
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "AnnotationPrinter/AnnotationPrinterSettings.hh"
+
 #include "clang/AST/ASTConsumer.h"
 
 namespace AnnotationPrinter
@@ -8,7 +10,12 @@ namespace AnnotationPrinter
     class AnnotationPrinterConsumer : public clang::ASTConsumer
     {
 
+    private:
+        AnnotationPrinterSettings APSettings;
+
     public:
+        explicit AnnotationPrinterConsumer(AnnotationPrinterSettings APSettings);
+
         virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
     };
 } // namespace AnnotationPrinter
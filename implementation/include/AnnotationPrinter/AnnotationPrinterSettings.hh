@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+namespace AnnotationPrinter
+{
+    struct AnnotationPrinterSettings
+    {
+        // Manifest to look compact annotations up in.
+        // Empty if there is none
+        std::string AnnotationManifestPath = "";
+
+        // Directory whose source files and headers to print the annotations
+        // of, instead of those in the translation unit.
+        // Empty if the translation unit's annotations should be printed
+        std::string ProjectDir = "";
+    };
+} // namespace AnnotationPrinter
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <string>
+
 namespace AnnotationRemover
 {
     struct AnnotationRemoverSettings
     {
         bool OverwriteFiles = false;
+        // Directory that in-place runs write their edits to files other
+        // than the main file to, for merge_header_edits.py to apply.
+        // Empty if all files should be written directly
+        std::string HeaderEditsDir = "";
     };
 } // namespace AnnotationRemover
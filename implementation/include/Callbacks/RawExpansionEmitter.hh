@@ -0,0 +1,29 @@
+#pragma once
+
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/MacroArgs.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/Token.h"
+
+namespace Callbacks
+{
+    // Emits the same raw macro expansion messages as the MacroForest,
+    // without building the forest
+    class RawExpansionEmitter : public clang::PPCallbacks
+    {
+    private:
+        clang::Preprocessor &PP;
+        clang::SourceManager &SM;
+
+    public:
+        RawExpansionEmitter(clang::Preprocessor &PP, clang::SourceManager &SM);
+
+        void MacroExpands(
+            const clang::Token &MacroNameTok,
+            const clang::MacroDefinition &MD,
+            clang::SourceRange Range,
+            const clang::MacroArgs *Args) override;
+    };
+} // namespace Callbacks
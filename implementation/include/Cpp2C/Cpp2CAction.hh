@@ -2,6 +2,7 @@
 
 #include "Cpp2C/Cpp2CCommand.hh"
 #include "Transformer/TransformerSettings.hh"
+#include "AnnotationPrinter/AnnotationPrinterSettings.hh"
 #include "AnnotationRemover/AnnotationRemoverSettings.hh"
 
 #include "clang/Frontend/CompilerInstance.h"
@@ -16,6 +17,11 @@ namespace Cpp2C
 {
     class Cpp2CAction : public clang::PluginASTAction
     {
+    public:
+        // Returns true if Clang was given a serialized AST (e.g., a .ast file
+        // from clang -emit-ast) instead of a source file
+        static bool isASTInput(const clang::CompilerInstance &CI);
+
 
     protected:
         std::unique_ptr<clang::ASTConsumer>
@@ -34,6 +40,7 @@ namespace Cpp2C
         Cpp2CCommand Command = HELP;
         Transformer::TransformerSettings TSettings;
         AnnotationRemover::AnnotationRemoverSettings ARSettings;
+        AnnotationPrinter::AnnotationPrinterSettings APSettings;
     };
 
 } // namespace Transformer
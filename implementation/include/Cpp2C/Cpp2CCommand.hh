@@ -8,6 +8,7 @@ namespace Cpp2C
         TRANSFORM,
         DEDUPLICATE,
         PRINT_ANNOTATIONS,
-        REMOVE_ANNOTATIONS
+        REMOVE_ANNOTATIONS,
+        ABSTRACTION_METRICS
     };
 } // namespace Cpp2C
\ No newline at end of file
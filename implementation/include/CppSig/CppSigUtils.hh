@@ -37,6 +37,12 @@ namespace CppSig
         clang::ASTContext &Ctx,
         CppSig::MacroForest::Roots &ExpansionRoots);
 
+    // Matches the arguments of every expansion in the given top-level
+    // expansion's forest to the AST nodes expanded from them
+    void matchArguments(
+        clang::ASTContext &Ctx,
+        MacroExpansionNode *ToplevelExpansion);
+
     // If ST is an Expr, then returns its desugared canonical type.
     // Otherwise, returns "@stmt"
     std::string getType(clang::ASTContext &Ctx, const clang::Stmt *ST);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/Frontend/FrontendAction.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace MacroCounter
+{
+    // Emits the macro definition and raw macro expansion messages that
+    // cpp2c tr -v emits, but only runs the preprocessor, so the
+    // translation unit is never parsed or semantically analyzed.
+    // Since it replaces Clang's main action instead of being added before
+    // it, it is registered as its own plugin, cpp2c-count
+    class MacroCounterAction : public clang::PluginASTAction
+    {
+    protected:
+        // Never called, since the action only uses the preprocessor
+        std::unique_ptr<clang::ASTConsumer>
+        CreateASTConsumer(
+            clang::CompilerInstance &CI,
+            llvm::StringRef file) override;
+
+        bool ParseArgs(
+            const clang::CompilerInstance &CI,
+            const std::vector<std::string> &args) override;
+
+        clang::PluginASTAction::ActionType getActionType() override;
+
+        bool usesPreprocessorOnly() const override;
+
+        void ExecuteAction() override;
+
+    private:
+        std::set<std::string> MacroNames;
+        std::set<std::string> MultiplyDefinedMacros;
+    };
+} // namespace MacroCounter
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "nlohmann/single_include/json.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Summarizer
+{
+    // Interns strings as dense IDs, assigned in the order the strings are
+    // first seen
+    class StringPool
+    {
+    private:
+        std::unordered_map<std::string, unsigned> IDs;
+        std::vector<std::string> Strings;
+
+    public:
+        unsigned intern(const std::string &S);
+
+        const std::string &get(unsigned ID) const;
+    };
+
+    // Incrementally computes the summary statistics of an evaluated program
+    // from the event records cpp2c emits while counting and transforming
+    // its macros.
+    //
+    // Event records are grouped by translation unit. Each translation
+    // unit's events are preceded by a header line:
+    //
+    //     CPP2C:Translation Unit <TAB> (count|transform) <TAB> RUN <TAB> FILE <TAB> SECONDS
+    //
+    // followed by the lines that cpp2c printed to stderr for it.
+    // count records come from cpp2c count on the untransformed program,
+    // and transform records from the RUN-th run of the fixed-point loop.
+    //
+    // Every string is only stored once, and spelling locations are only
+    // stored as hashes, so memory use grows with the number of distinct
+    // macros, declarations and expansions rather than with the number of
+    // events. Summaries of disjoint sets of records can be saved as shards
+    // and merged.
+    class EventSummary
+    {
+    private:
+        StringPool Macros;
+        StringPool Files;
+        // Declaration names, signatures, types, and categories
+        StringPool Names;
+
+        // From count records
+
+        std::set<unsigned> SourceMacroDefinitions;
+        // Maps each macro to the hashes of the spelling locations of its
+        // expansions
+        std::map<unsigned, std::set<std::uint64_t>> RawExpansionSpellingLocations;
+
+        // From transform records
+
+        unsigned RunsToFixedPoint = 0;
+        // Maps each potentially transformable macro to the signatures of its
+        // potentially transformable expansions
+        std::map<unsigned, std::set<unsigned>> PotentiallyTransformableMacroRawSigs;
+        // Maps each file to the greatest and the total time taken to
+        // transform it
+        std::map<unsigned, std::pair<double, double>> FileTransformSeconds;
+        std::map<unsigned, std::set<unsigned>> CategoriesNotTransformed;
+        std::set<unsigned> TransformedDeclNames;
+        std::set<unsigned> TransformedMacros;
+        // Maps each transformed macro to the first transformed definition
+        // one of its transformed expansions referred to
+        std::map<unsigned, unsigned> TransformedDefToVisit;
+        // Maps each file and the declaration each transformed expansion
+        // was found in to the number of transformed expansions of each
+        // macro found there
+        std::map<std::pair<unsigned, unsigned>, std::map<unsigned, unsigned>> TransformedInvocations;
+        std::map<unsigned, std::set<unsigned>> TransformedTypes;
+        std::set<unsigned> MacrosTransformedToVars;
+
+        // Number of translation units Clang crashed on
+        unsigned Crashes = 0;
+
+        void addEvent(
+            const std::string &Phase,
+            unsigned File,
+            const std::vector<std::string> &Fields);
+
+    public:
+        // Adds the event records read from the given stream.
+        // Returns false and sets Err if the stream is malformed
+        bool addRecords(std::istream &IS, std::string &Err);
+
+        // Adds the summary saved in the given shard.
+        // Returns false and sets Err if the shard is malformed
+        bool addShard(const nlohmann::json &Shard, std::string &Err);
+
+        // Returns the summary as a shard that addShard can read
+        nlohmann::json toShard() const;
+
+        // Returns the number of translation units Clang crashed on
+        unsigned getCrashes() const;
+
+        // Prints the summary in the format of the results files
+        void print(std::ostream &OS) const;
+    };
+} // namespace Summarizer
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Transformer/SignatureVerdictCache.hh"
+#include "Transformer/TransformerSettings.hh"
+#include "Utils/AnnotationManifest.hh"
+#include "Utils/UniqueNameGenerator.hh"
+
+#include "clang/Frontend/CompilerInstance.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace Transformer
+{
+    // The outcome of transforming a translation unit once
+    struct TransformationResult
+    {
+        // Number of expansions that were transformed
+        unsigned TransformedExpansions = 0;
+        // Maps the path of each file that was edited to its new contents
+        std::map<std::string, std::string> RewrittenFiles;
+        // Whether the translation unit's time budget ran out, in which
+        // case nothing was rewritten
+        bool BudgetExceeded = false;
+    };
+
+    // Transforms a translation unit repeatedly until no more of its
+    // expansions can be transformed.
+    // Rewritten files are kept in an in-memory file system overlaid on
+    // the real one, so later iterations parse them from memory.
+    // The driver doesn't write anything itself; once it is done, its
+    // caller writes out the final files
+    class FixedPointDriver
+    {
+    private:
+        clang::CompilerInstance &CI;
+        TransformerSettings TSettings;
+        std::shared_ptr<Utils::UniqueNameGenerator> Names;
+        // Shared by every iteration, so that later iterations see the
+        // verdicts and annotations of earlier ones before they are saved
+        std::shared_ptr<SignatureVerdictCache> VerdictCache;
+        std::shared_ptr<Utils::AnnotationManifest> Manifest;
+
+        // When the translation unit's time budget runs out.
+        // Iterations only get the time that is left of it
+        std::chrono::steady_clock::time_point TUDeadline;
+
+        // The current contents of every file rewritten so far
+        std::map<std::string, std::string> Buffers;
+        // Whether the time budget ran out before a fixed point was reached
+        bool BudgetExceeded = false;
+
+        // Whether an iteration is currently running
+        static bool Running;
+
+        // Transforms the translation unit once, reading the rewritten
+        // files from memory. Returns true on failure
+        bool runIteration(TransformationResult &Result);
+
+    public:
+        FixedPointDriver(
+            clang::CompilerInstance &CI,
+            TransformerSettings TSettings,
+            std::shared_ptr<Utils::UniqueNameGenerator> Names,
+            std::shared_ptr<SignatureVerdictCache> VerdictCache,
+            std::shared_ptr<Utils::AnnotationManifest> Manifest,
+            std::chrono::steady_clock::time_point TUDeadline);
+
+        // Runs iterations until one transforms no expansions, or the
+        // translation unit's time budget runs out. FirstResult is the
+        // result of the first iteration, which the plugin itself runs.
+        // Returns true on failure
+        bool run(const TransformationResult &FirstResult);
+        // Returns true if the translation unit's time budget ran out
+        // before a fixed point was reached. If so, the translation unit
+        // is left as it was, so nothing should be written
+        bool budgetExceeded() const;
+
+        // Returns the final contents of the file at the given path, or
+        // null if it was never rewritten
+        const std::string *getRewrittenFile(const std::string &Path) const;
+
+        // Writes all the rewritten files to disk. All the files are written
+        // to temporary files before any of them are renamed over the
+        // originals, so an interrupted run leaves the originals intact.
+        // Returns true on failure
+        bool flush();
+
+        // Returns true if an iteration is currently running.
+        // The plugin must not add itself to iterations' compiler instances,
+        // since they run their own transformer
+        static bool isRunning();
+    };
+} // namespace Transformer
@@ -7,23 +7,68 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 
+#include <chrono>
+
 namespace Transformer
 {
+    // Checks which take a Deadline stop walking the AST once it passes,
+    // and return OUT_OF_TIME. Their verdict is then meaningless, so the
+    // caller must reject the expansion for running out of time instead.
+    // The default deadline never passes
+    extern std::string OUT_OF_TIME;
+
     // Checks if a given macro expansion is syntactically well-formed.
     // If so, returns the empty string.
     // If not, returns an error message.
+    // This is equivalent to checking isInConstExprContext,
+    // isWellFormedStructure, and isWellFormedSpelling, in that order.
     std::string isWellFormed(
         CppSig::MacroExpansionNode *Expansion,
         clang::ASTContext &Ctx,
         clang::Preprocessor &PP);
 
+    // Checks if a given macro expansion appears where a constant expression
+    // is required.
+    // If AllowEnumConstants is true, then expansions which will be
+    // transformed to enum constants may appear there.
+    // If so, returns an error message.
+    // If not, returns the empty string.
+    std::string isInConstExprContext(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx,
+        bool AllowEnumConstants = false);
+
+    // Checks if a given macro expansion maps to a single expression
+    // with an unambiguous signature.
+    // All the other property checks assume that this check has passed.
+    // If so, returns the empty string.
+    // If not, returns an error message.
+    std::string isWellFormedStructure(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx);
+
+    // Checks if the expression a given macro expansion maps to, and those
+    // of its arguments, are spelled exactly where the expansion and its
+    // arguments are.
+    // Assumes isWellFormedStructure has already been checked.
+    // If so, returns the empty string.
+    // If not, returns an error message.
+    std::string isWellFormedSpelling(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx,
+        clang::Preprocessor &PP,
+        std::chrono::steady_clock::time_point Deadline =
+            std::chrono::steady_clock::time_point::max());
+
     // Checks if a given macro expansion captures any variables from its
     // environment.
     // If so, returns an error message.
     // If not, returns the empty string.
     std::string isEnvironmentCapturing(
         CppSig::MacroExpansionNode *Expansion,
-        clang::ASTContext &Ctx);
+        clang::ASTContext &Ctx,
+        std::chrono::steady_clock::time_point Deadline =
+            std::chrono::steady_clock::time_point::max());
 
     // Checks if a given macro expansion does not have parameter side-effects
     // and is L-value independent.
@@ -45,10 +90,22 @@ namespace Transformer
     // transformed code, and they will not be.
     std::string isParamSEFreeAndLValueIndependent(
         CppSig::MacroExpansionNode *Expansion,
-        clang::ASTContext &Ctx);
+        clang::ASTContext &Ctx,
+        std::chrono::steady_clock::time_point Deadline =
+            std::chrono::steady_clock::time_point::max());
+
+    // Checks if a given transformed definition's signature or original
+    // macro definition contains an untransformable language construct.
+    // These checks only depend on the macro definition and the transformed
+    // signature, so their result can be cached per definition/signature.
+    // If so, returns an error message.
+    // If not, returns the empty string.
+    std::string isUnsupportedSignature(
+        Transformer::TransformedDefinition *TD);
 
     // Checks if a given transformed definition contains an untransformable
-    // language construct.
+    // language construct at the site it was expanded at.
+    // Assumes isUnsupportedSignature has already been checked.
     // If so, returns an error message.
     // If not, returns the empty string.
     // TODO: Change this to take a MacroExpansionNode as an argument,
@@ -56,7 +113,6 @@ namespace Transformer
     std::string isUnsupportedConstruct(
         Transformer::TransformedDefinition *TD,
         clang::ASTContext &Ctx,
-        clang::Rewriter &RW,
-        std::set<std::string> AllowedMacroDefFileRealPaths);
+        const std::set<std::string> &AllowedMacroDefFileRealPaths);
 
 } // namespace Transformer
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "CppSig/MacroExpansionNode.hh"
+#include "Transformer/SignatureVerdictCache.hh"
+#include "Transformer/TransformedDefinition.hh"
+#include "Transformer/TransformerSettings.hh"
+#include "Utils/TypeStringCache.hh"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Lex/Preprocessor.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Transformer
+{
+    // Categories of reasons an expansion is not transformed
+    extern std::string SYNTAX,
+        ENVIRONMENT_CAPTURE,
+        PARAMETER_SIDE_EFFECTS,
+        UNSUPPORTED_CONSTRUCT,
+        TURNED_OFF_CONSTRUCT,
+        TIME_BUDGET_EXCEEDED;
+
+    // The category and reason an expansion was rejected for.
+    // Both are empty if the expansion passed every check
+    struct PropertyVerdict
+    {
+        std::string Category;
+        std::string Reason;
+
+        bool passed() const;
+    };
+
+    // Everything the property checks for a single expansion may need
+    struct PropertyCheckContext
+    {
+        CppSig::MacroExpansionNode *Expansion;
+        clang::ASTContext &Ctx;
+        clang::Preprocessor &PP;
+        const std::set<std::string> &AllowedMacroDefFileRealPaths;
+        SignatureVerdictCache &VerdictCache;
+        Utils::TypeStringCache &TypeStrings;
+
+        // The transformed definition of the expansion.
+        // Only created once a check needs it
+        std::unique_ptr<TransformedDefinition> TD;
+
+        // State of the pipeline for this expansion, so that it can be run
+        // over several calls (e.g., the thread-safe stages in parallel,
+        // then the rest serially).
+        // Whether each stage has run (and passed, unless it is the
+        // rejecting stage)
+        std::vector<bool> RanStages;
+        // Whether a stage has rejected the expansion
+        bool Rejected = false;
+        // The index of the stage to report the rejection under
+        std::size_t RejectingStage = 0;
+        // The verdict so far
+        PropertyVerdict Verdict;
+
+        // Time spent analyzing the expansion so far
+        std::chrono::steady_clock::duration AnalysisTime =
+            std::chrono::steady_clock::duration::zero();
+        // When the translation unit's time budget runs out
+        std::chrono::steady_clock::time_point TUDeadline =
+            std::chrono::steady_clock::time_point::max();
+        // When the running stage must stop, so that it doesn't exceed
+        // either budget. Stages pass it to the checks they run
+        std::chrono::steady_clock::time_point StageDeadline =
+            std::chrono::steady_clock::time_point::max();
+
+        PropertyCheckContext(
+            CppSig::MacroExpansionNode *Expansion,
+            clang::ASTContext &Ctx,
+            clang::Preprocessor &PP,
+            const std::set<std::string> &AllowedMacroDefFileRealPaths,
+            SignatureVerdictCache &VerdictCache,
+            Utils::TypeStringCache &TypeStrings);
+
+        // Returns the transformed definition of the expansion,
+        // creating it if it has not been created yet.
+        // Must only be called once the expansion is known to be
+        // structurally well-formed
+        TransformedDefinition *getTD();
+    };
+
+    // Rough relative cost of a property check stage
+    enum PropertyCheckCost
+    {
+        // Constant-time checks, or single walks of the expansion's subtree
+        CHEAP,
+        // Walks of the expansion's subtree and its arguments, or short
+        // walks up the AST
+        MODERATE,
+        // Repeated walks up the AST or over all argument pairs
+        EXPENSIVE
+    };
+
+    // A single stage of the property check pipeline
+    struct PropertyCheckStage
+    {
+        // Name of the stage, for debugging
+        std::string Name;
+        // The category the stage reports rejections under
+        std::string Category;
+        // How expensive the stage is to run
+        PropertyCheckCost Cost;
+        // Whether the stage only reads the AST, and so can run on many
+        // expansions in parallel once the parent map has been built.
+        // Stages that use the SourceManager are not thread-safe, since its
+        // lookups update internal caches
+        bool ThreadSafe;
+        // The check itself. Returns the empty string if the expansion
+        // passes the check, or the reason it does not otherwise
+        std::function<std::string(PropertyCheckContext &)> Check;
+    };
+
+    // Pipeline of property checks that decides whether an expansion
+    // can be transformed.
+    // Since an expansion is only transformed if it passes every check, the
+    // order the checks run in does not affect the verdict, only which
+    // reason is reported. The pipeline runs the cheapest checks first so
+    // that most rejections are reached sooner.
+    class PropertyPipeline
+    {
+    private:
+        // The stages, in the canonical order that determines which
+        // category and reason are reported for a rejected expansion
+        std::vector<PropertyCheckStage> Stages;
+
+        // Indices of Stages, sorted by cost
+        std::vector<std::size_t> CostOrder;
+
+        unsigned ExpansionBudgetMs;
+        unsigned TUBudgetMs;
+
+    public:
+        explicit PropertyPipeline(const TransformerSettings &TSettings);
+
+        // Returns the reason the expansion in the given context has run
+        // out of time to be analyzed, or the empty string if it has not
+        std::string checkBudget(const PropertyCheckContext &PCC) const;
+
+        // Rejects the expansion in the given context for exceeding its
+        // time budget if it has run out of time.
+        // Returns true if the expansion has been rejected for that,
+        // now or before
+        bool rejectIfOverBudget(PropertyCheckContext &PCC) const;
+
+        // Runs the checks on the expansion in the given context,
+        // cheapest first, and stops at the first rejection.
+        // If the expansion's or the translation unit's time budget runs
+        // out before or during a check, the expansion is rejected for
+        // exceeding it instead, and no more checks are run.
+        // If Attribute is true, then before reporting a rejection, also
+        // runs any skipped stages that come before the rejecting stage in
+        // the canonical order, so that the reported category and reason
+        // are identical to those of running the stages in canonical order.
+        // Stages which already ran are never run again, and these are run
+        // cheapest first as well, so that a cheap stage that fails spares
+        // running the expensive stages after it.
+        // If OnlyThreadSafe is true, then only thread-safe stages are run,
+        // and the returned verdict is provisional; calling run again
+        // on the same context resumes with the remaining stages
+        PropertyVerdict run(
+            PropertyCheckContext &PCC,
+            bool Attribute,
+            bool OnlyThreadSafe = false) const;
+
+        const std::vector<PropertyCheckStage> &getStagesRef() const;
+    };
+} // namespace Transformer
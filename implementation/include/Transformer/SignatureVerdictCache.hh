@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace Transformer
+{
+    // Cache of verdicts for the property checks which only depend on a
+    // macro's definition and the signature of its transformation, not on
+    // the site it was expanded at.
+    // Verdicts are keyed by the macro's hash, a digest of its definition's
+    // body, and its transformed signature, so that they remain valid across
+    // fixed-point runs and can be persisted to a file between them.
+    // The macro hash only identifies the definition by name and location,
+    // so the body is part of the key in case the macro is edited between
+    // runs that share a cache file
+    class SignatureVerdictCache
+    {
+    private:
+        // Maps each key to the verdict for that
+        // definition/signature pair. The empty string means the pair
+        // passed all the signature-only checks
+        std::map<std::string, std::string> Verdicts;
+
+        // Whether any verdicts were added since the cache was loaded
+        bool Dirty = false;
+
+        // Guards the cache, since verdicts may be looked up and inserted
+        // from the parallel analysis phase
+        mutable std::mutex Mutex;
+
+    public:
+        // Creates the key for a given macro hash, definition text, and
+        // transformed signature
+        static std::string key(
+            const std::string &MacroHash,
+            const std::string &DefinitionText,
+            const std::string &Signature);
+
+        // If a verdict has been cached for the given key, sets Verdict to it
+        // and returns true. Otherwise returns false
+        bool lookup(const std::string &Key, std::string &Verdict) const;
+
+        // Caches the verdict for the given key
+        void insert(const std::string &Key, const std::string &Verdict);
+
+        // Adds all the verdicts stored in the given file to the cache.
+        // Does nothing if the file does not exist or cannot be parsed
+        void load(const std::string &Path);
+
+        // Writes the cache to the given file if it has any new verdicts,
+        // merged with the verdicts already in the file.
+        // The file is locked while it is merged and written, since
+        // translation units transformed in parallel may share it, and it
+        // is written to a temporary file first and then renamed, so
+        // readers never see a partially written cache
+        void save(const std::string &Path);
+    };
+} // namespace Transformer
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CppSig/MacroExpansionNode.hh"
+#include "Utils/TypeStringCache.hh"
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Type.h"
@@ -30,18 +31,35 @@ namespace Transformer
         std::string InitializerOrDefinition;
         // The name used when emitting this definition
         std::string EmittedName;
+        // Prints the types in the signature
+        Utils::TypeStringCache &TypeStrings;
+
+        // The signature without the emitted name, and the index in it
+        // that the emitted name is inserted at.
+        // Computed the first time the signature is requested
+        bool SignatureComputed = false;
+        std::string SignatureNoName;
+        std::size_t EmittedNameIndex = 0;
+        // The signature with the emitted name, or empty if it has not been
+        // requested since the emitted name was last set
+        std::string SignatureWithName;
+
+        // Prints the signature of this transformed definition
+        void computeSignature(clang::ASTContext &Ctx);
 
     public:
         TransformedDefinition(
             clang::ASTContext &Ctx,
-            CppSig::MacroExpansionNode *Expansion);
+            CppSig::MacroExpansionNode *Expansion,
+            Utils::TypeStringCache &TypeStrings);
 
         std::string getEmittedName();
         void setEmittedName(std::string s);
         CppSig::MacroExpansionNode *getExpansion();
 
         // Gets the signature for this transformed expansion if it's a function;
-        // otherwise gets the declaration
+        // otherwise gets the declaration.
+        // The signature is only printed once
         std::string getExpansionSignatureOrDeclaration(
             clang::ASTContext &Ctx,
             bool includeEmittedName);
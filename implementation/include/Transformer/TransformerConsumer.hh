@@ -1,15 +1,23 @@
 #pragma once
 
+#include "Transformer/FixedPointDriver.hh"
+#include "Transformer/PropertyPipeline.hh"
+#include "Transformer/SignatureVerdictCache.hh"
 #include "Transformer/TransformerSettings.hh"
 #include "CppSig/MacroExpansionNode.hh"
 #include "CppSig/MacroForest.hh"
+#include "Utils/AnnotationManifest.hh"
+#include "Utils/TypeStringCache.hh"
+#include "Utils/UniqueNameGenerator.hh"
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/CompilerInstance.h"
 
+#include <chrono>
 #include <set>
 #include <string>
 #include <map>
+#include <memory>
 
 namespace Transformer
 {
@@ -26,11 +34,54 @@ namespace Transformer
 
         TransformerSettings TSettings;
 
+        // Cached verdicts of the signature-only property checks
+        std::shared_ptr<SignatureVerdictCache> VerdictCache;
+
+        // Full annotations of the transformed declarations, if they are
+        // annotated with compact IDs
+        std::shared_ptr<Utils::AnnotationManifest> Manifest;
+
+        // Printed forms of the types in transformed signatures
+        Utils::TypeStringCache TypeStrings;
+
+        // Generates the names of transformed definitions, and tracks the
+        // symbols they must not collide with
+        std::shared_ptr<Utils::UniqueNameGenerator> Names;
+
+        // If not null, the result of the transformation is recorded here
+        // instead of being written out
+        TransformationResult *Result;
+
+        // The property checks to run on each top-level expansion
+        PropertyPipeline Pipeline;
+
+        // When the translation unit's time budget runs out
+        std::chrono::steady_clock::time_point TUDeadline =
+            std::chrono::steady_clock::time_point::max();
+
+
     public:
-        explicit TransformerConsumer(clang::CompilerInstance *CI, TransformerSettings TSettings);
+        // If Names is null, then the consumer creates its own name generator.
+        // Likewise, if VerdictCache or Manifest is null, then the consumer
+        // creates its own, loaded from the files given in TSettings.
+        // Iterations of the fixed-point driver are passed those of the
+        // consumer that started it, which saves them once it is done
+        explicit TransformerConsumer(
+            clang::CompilerInstance *CI,
+            TransformerSettings TSettings,
+            std::shared_ptr<Utils::UniqueNameGenerator> Names = nullptr,
+            TransformationResult *Result = nullptr,
+            std::shared_ptr<SignatureVerdictCache> VerdictCache = nullptr,
+            std::shared_ptr<Utils::AnnotationManifest> Manifest = nullptr);
 
         virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
 
         void debugMsg(std::string s);
+
+        // Reports that the translation unit could not be transformed as a
+        // compiler error, so that the process fails instead of looking like
+        // it had nothing to transform. When printing, still prints the
+        // unmodified main file, so that the output is always a complete file
+        void reportFailure(clang::ASTContext &Ctx, const std::string &Msg);
     };
 } // namespace Transformer
@@ -1,7 +1,47 @@
 #pragma once
 
+#include <string>
+
 namespace Transformer
 {
+    // What the transformer outputs
+    enum TransformerEmitMode
+    {
+        // The rewritten main file, or rewritten files if editing in place
+        EMIT_FILES,
+        // The edits to every touched file, as YAML replacements
+        EMIT_REPLACEMENTS,
+        // The edits to every touched file, as a unified diff
+        EMIT_PATCH
+    };
+
+    // How transformed functions are marked for inlining
+    enum TransformerInlineMode
+    {
+        // Emit transformed functions as plain static functions
+        INLINE_NONE,
+        // Emit transformed functions as static inline functions
+        INLINE_HINT,
+        // Emit transformed functions as static inline functions that the
+        // compiler must inline
+        INLINE_ALWAYS
+    };
+
+    // How transformations of object-like macros that expand to integer
+    // constant expressions are emitted
+    enum TransformerConstantMode
+    {
+        // As static variables, like any other object-like macro
+        CONSTANTS_VARS,
+        // As static const variables
+        CONSTANTS_CONST,
+        // As enum constants if they have type int, and as static const
+        // variables otherwise.
+        // Enum constants may also replace expansions where a constant
+        // expression is required
+        CONSTANTS_ENUM
+    };
+
     struct TransformerSettings
     {
         bool OverwriteFiles = false;
@@ -9,5 +49,43 @@ namespace Transformer
         bool OnlyCollectNotDefinedInStdHeaders = true;
         bool TransformConditionalEvaluation = false;
         bool DeduplicateWhileTransforming = false;
+        // Whether expansions of different macros whose definitions and
+        // signatures are equivalent share one transformed definition
+        bool DeduplicateByContent = false;
+        // File to persist signature-only property check verdicts to
+        // across runs. Empty if verdicts should not be persisted
+        std::string VerdictCachePath = "";
+        // Number of threads to check expansions' properties with.
+        // 0 means use all available cores
+        unsigned Jobs = 1;
+        TransformerEmitMode EmitMode = EMIT_FILES;
+        // Directory that in-place runs write their edits to files other
+        // than the main file to, for merge_header_edits.py to apply.
+        // Empty if all files should be written directly
+        std::string HeaderEditsDir = "";
+        // Whether to transform the translation unit repeatedly in memory
+        // until no more expansions can be transformed, and only then
+        // write the rewritten files
+        bool FixedPoint = false;
+        TransformerInlineMode InlineMode = INLINE_NONE;
+        TransformerConstantMode ConstantMode = CONSTANTS_VARS;
+        // File to record the full annotations of transformed declarations
+        // in, so that the declarations themselves are only annotated with
+        // compact IDs. Empty if declarations should be annotated with
+        // their full annotations
+        std::string AnnotationManifestPath = "";
+        // Analysis time allowed for each top-level expansion, in
+        // milliseconds. Expansions whose checks have not finished when it
+        // runs out are not transformed. 0 means unlimited
+        unsigned ExpansionBudgetMs = 0;
+        // Wall time allowed for transforming the translation unit, in
+        // milliseconds, counted from when it starts being parsed.
+        // If it runs out before every expansion has been analyzed, the
+        // translation unit is left as it was. Only used if HasTUBudget is
+        // true. 0 means the budget runs out before any expansion is
+        // analyzed, so the translation unit is never transformed
+        unsigned TUBudgetMs = 0;
+        // Whether transforming the translation unit has a time budget
+        bool HasTUBudget = false;
     };
 } // namespace Transformer
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Utils/TransformedDeclarationAnnotation.hh"
+
+#include "llvm/ADT/StringRef.h"
+
+#include <map>
+#include <string>
+
+namespace Utils
+{
+    // Per-project file of the full annotations of transformed declarations,
+    // for emitting compact annotations.
+    // A compact annotation only holds a short ID which is stable across
+    // translation units, so declarations emitted for the same
+    // transformation are identical, and are never rewritten when a
+    // definition is emitted to a new file. The full annotation, including
+    // the set of files definitions were emitted to, is recorded in the
+    // manifest under that ID instead
+    class AnnotationManifest
+    {
+    private:
+        // Maps each compact annotation to its full annotation
+        std::map<std::string, TransformedDeclarationAnnotation> Annotations;
+
+        // Whether any annotations were added or updated since the manifest
+        // was loaded
+        bool Dirty = false;
+
+        // Adds the annotation to the given map under the given ID,
+        // unioning its definition realpaths with those of any annotation
+        // already there. Returns true if the map changed
+        static bool merge(
+            std::map<std::string, TransformedDeclarationAnnotation> &Annotations,
+            const std::string &ID,
+            const TransformedDeclarationAnnotation &TDA);
+
+        // Reads the annotations stored in the given file into the given
+        // map. Does nothing if the file does not exist or cannot be parsed
+        static void read(
+            const std::string &Path,
+            std::map<std::string, TransformedDeclarationAnnotation> &Annotations);
+
+    public:
+        // Returns the compact annotation for the given annotation
+        static std::string getCompactAnnotation(
+            const TransformedDeclarationAnnotation &TDA);
+
+        // Returns true if the given annotation string is a compact annotation
+        static bool isCompactAnnotation(llvm::StringRef Annotation);
+
+        // Records the given annotation under its compact annotation,
+        // adding its definition realpaths to any already recorded.
+        // Returns the compact annotation
+        std::string insert(const TransformedDeclarationAnnotation &TDA);
+
+        // Sets TDA to the full annotation for the given annotation string,
+        // which may be either compact or full JSON, and returns true.
+        // Returns false if the annotation is malformed, or if it is compact
+        // and not in the manifest
+        bool lookup(
+            llvm::StringRef Annotation,
+            TransformedDeclarationAnnotation &TDA) const;
+
+        // Adds all the annotations stored in the given file to the manifest.
+        // Does nothing if the file does not exist or cannot be parsed
+        void load(const std::string &Path);
+
+        // Writes the manifest to the given file if it has changed.
+        // Translation units may be transformed in parallel, so the file is
+        // locked, and its current contents are merged with the manifest
+        // before it is written to a temporary file and renamed
+        void save(const std::string &Path);
+    };
+} // namespace Utils
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "clang/Basic/LangOptions.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    // Returns the Cpp2C annotations in the given source text, in the order
+    // they appear. The text is only lexed, not preprocessed or parsed, so
+    // annotations are found even in code that is excluded by conditional
+    // compilation, and annotations produced by macro expansion are missed
+    std::vector<std::string> scanCpp2CAnnotations(
+        llvm::StringRef Buffer,
+        const clang::LangOptions &LO);
+
+    // Returns the paths of the C source files and headers under the given
+    // directory, in sorted order
+    std::vector<std::string> collectSourceFiles(const std::string &Dir);
+} // namespace Utils
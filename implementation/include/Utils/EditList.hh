@@ -0,0 +1,130 @@
+#pragma once
+
+#include "nlohmann/single_include/json.hpp"
+
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Tooling/Core/Replacement.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    // A list of text edits to the files of a translation unit.
+    // Edits are only recorded as they are added, and are applied to each
+    // file in a single pass once all of them are known. This is cheaper
+    // than editing a clang::Rewriter's buffers one edit at a time when
+    // a file has many edits.
+    // Edits at the same location are ordered the same way a Rewriter
+    // orders them: insertions are placed before any text previously
+    // inserted there, and replacement text after it
+    class EditList
+    {
+    public:
+        // A single edit to a file, in terms of offsets into the
+        // original file
+        struct Edit
+        {
+            unsigned Offset;
+            // Number of bytes of the original file this edit removes
+            unsigned Length;
+            std::string Text;
+            // Whether the text is inserted before any text that was
+            // previously inserted at the same offset
+            bool InsertBefore;
+            // The order the edit was added in
+            unsigned Sequence;
+            // Identifies what the edit emits (e.g., a transformed
+            // declaration), so that identical edits made by different
+            // translation units can be merged. Empty if the edit
+            // need not be merged
+            std::string Key;
+        };
+
+    private:
+        clang::SourceManager &SM;
+        const clang::LangOptions &LO;
+
+        // Edits to each file, in the order they were added
+        std::map<clang::FileID, std::vector<Edit>> Edits;
+        unsigned NextSequence = 0;
+
+        // Merges all the edits to the given file, so that there is at most
+        // one edit per offset, and sorts them by offset.
+        // Returns false and sets Err if any edits overlap
+        bool getMergedEdits(
+            clang::FileID FID,
+            std::vector<Edit> &Merged,
+            std::string &Err) const;
+
+    public:
+        EditList(clang::SourceManager &SM, const clang::LangOptions &LO);
+
+        // Like Rewriter::InsertTextBefore and Rewriter::ReplaceText, these
+        // return true if the location cannot be edited, and false otherwise.
+        // Ranges are token ranges
+        bool insertTextBefore(
+            clang::SourceLocation Loc,
+            llvm::StringRef Text,
+            llvm::StringRef Key = "");
+        bool replaceText(
+            clang::SourceRange Range,
+            llvm::StringRef Text,
+            llvm::StringRef Key = "");
+        // Removes the characters from Begin up to (but not including) End.
+        // Returns true if the range cannot be edited, and false otherwise
+        bool removeText(
+            clang::SourceLocation Begin,
+            clang::SourceLocation End,
+            llvm::StringRef Key = "");
+
+        // Returns the files that have edits
+        std::vector<clang::FileID> getEditedFiles() const;
+
+        // Checks that no two edits to the same file overlap.
+        // Returns false and sets Err if any do
+        bool validate(std::string &Err) const;
+
+        // Returns the contents of the given file with all of its edits
+        // applied. The file must not have overlapping edits
+        std::string getRewrittenBuffer(clang::FileID FID) const;
+
+        // Writes the given file back to disk with its edits applied.
+        // The file is written to a temporary file first and then renamed
+        // over the original.
+        // Returns true if the file could not be written
+        bool overwriteFile(clang::FileID FID) const;
+
+        // Writes every edited file back to disk.
+        // Returns true if any file could not be written
+        bool overwriteChangedFiles() const;
+
+        // Returns the path that edits to the given file are recorded under
+        std::string getFilePath(clang::FileID FID) const;
+
+        // Returns the edits to the given file as Replacements, so that
+        // they can be applied without re-parsing the file.
+        // The file must not have overlapping edits
+        clang::tooling::Replacements toReplacements(clang::FileID FID) const;
+
+        // Returns the edits to the given file as a unified diff against the
+        // original file, with three lines of context.
+        // The file must not have overlapping edits
+        std::string toUnifiedDiff(clang::FileID FID) const;
+
+        // Returns the edits to the given file, in the order they were added,
+        // along with the file's path and the SHA-1 of its original contents
+        nlohmann::json toJSON(clang::FileID FID) const;
+
+        // Writes the main file back to disk with its edits applied, and
+        // records the edits to every other file in Dir, for
+        // merge_header_edits.py to apply once all translation units that
+        // edit them are done.
+        // Returns true if the main file or the record could not be written
+        bool overwriteMainFileAndRecordOthers(const std::string &Dir) const;
+    };
+} // namespace Utils
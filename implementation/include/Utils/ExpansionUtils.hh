@@ -9,9 +9,11 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Rewrite/Core/Rewriter.h"
+#include "llvm/ADT/FoldingSet.h"
 
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 // TODO: Divide these functions up under more meaningful namespaces
@@ -29,6 +31,37 @@ namespace Utils
         CppSig::MacroExpansionNode *Expansion,
         clang::ASTContext &Ctx);
 
+    // Returns true if the given expansion transforms to a variable whose
+    // initializer is an integer constant expression
+    bool transformsToIntegerConstant(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx);
+
+    // Returns true if the given expansion transforms to an integer constant
+    // of type int, which can be emitted as an enum constant
+    bool transformsToEnumConstant(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx);
+
+    // Returns the text of the given expansion's macro definition with its
+    // parameters replaced by their indices, so that definitions which only
+    // differ in the names of their parameters have the same text.
+    // Different definitions may also have the same text, so the text alone
+    // doesn't show that two definitions are equivalent
+    std::string getParameterIndependentDefinitionText(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::SourceManager &SM,
+        const clang::LangOptions &LO);
+
+    // Adds the structure of the expression the given expansion maps to
+    // to ID, with the subtrees of its arguments replaced by their indices.
+    // Expansions of equivalent definitions have the same profile,
+    // regardless of the arguments they were invoked with
+    void profileExpansionWithoutArguments(
+        clang::ASTContext &Ctx,
+        CppSig::MacroExpansionNode *Expansion,
+        llvm::FoldingSetNodeID &ID);
+
     // Returns true if the given SourceLocation is in a standard header file
     bool isInStdHeader(
         clang::SourceLocation L,
@@ -85,6 +118,18 @@ namespace Utils
         const clang::Stmt *Haystack,
         const clang::Stmt *Needle);
 
+    // Inserts the given Stmt and all its sub Stmts into the given set
+    void collectSubStmts(
+        const clang::Stmt *S,
+        std::unordered_set<const clang::Stmt *> &SubStmts);
+
+    // Returns true if the given Stmt or any of its sub Stmts is in the
+    // given set. Walks the Haystack only once, regardless of the number
+    // of Needles
+    bool containsAnyStmt(
+        const clang::Stmt *Haystack,
+        const std::unordered_set<const clang::Stmt *> &Needles);
+
     void collectStmtsThatChangeRValue(
         const clang::Stmt *S,
         std::set<const clang::Stmt *> *StmtsThatChangeRValue);
@@ -128,11 +173,6 @@ namespace Utils
 
     const clang::NamedDecl *getTopLevelNamedDeclStmtExpandedIn(clang::ASTContext &Ctx, const clang::Stmt *S);
 
-    std::string getUniqueNameForExpansionTransformation(
-        CppSig::MacroExpansionNode *Expansion,
-        std::set<std::string> &UsedSymbols,
-        clang::ASTContext &Ctx);
-
     // Given a pointer to a Type object, removes all pointers in the type
     // and returns the base type
     clang::QualType getPointeeType(clang::QualType T);
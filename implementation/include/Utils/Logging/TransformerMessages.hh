@@ -30,6 +30,13 @@ namespace Utils
             const clang::MacroInfo *MI,
             clang::SourceManager &SM);
 
+        // Hashes the macro an expansion is of the same way, but from the
+        // definition the preprocessor passes to expansion callbacks
+        std::string hashExpandedMacro(
+            const std::string MacroName,
+            const clang::MacroDefinition &MD,
+            clang::SourceManager &SM);
+
         void emitUntransformedMessage(
             llvm::raw_fd_ostream &OS,
             clang::ASTContext &Ctx,
@@ -44,6 +51,12 @@ namespace Utils
             clang::SourceManager &SM,
             const clang::LangOptions &LO);
 
+        void emitRawMacroExpansionMessage(
+            llvm::raw_fd_ostream &OS,
+            const std::string &MacroHash,
+            clang::SourceLocation SpellingLoc,
+            clang::SourceManager &SM);
+
         void emitMacroExpansionMessage(
             llvm::raw_fd_ostream &OS,
             CppSig::MacroExpansionNode *Expansion,
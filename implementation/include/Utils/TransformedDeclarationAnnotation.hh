@@ -73,4 +73,21 @@ namespace Utils
     // string, parses it to JSON, and the returns the parsed value
     nlohmann::json annotationStringToJson(std::string anno);
 
+    // Returns true if the given decl is a struct/union/enum forward
+    // declaration emitted by Cpp2C, false otherwise
+    bool isCpp2CForwardDeclaration(const clang::Decl *D);
+
+    // Returns true if the given annotation string was emitted by Cpp2C,
+    // i.e., it is the annotation of a forward declaration, or the JSON
+    // or compact annotation of a transformed declaration
+    bool isCpp2CAnnotation(llvm::StringRef Annotation);
+
+    // Returns false if none of the files loaded by the given SourceManager
+    // contain the marker that all Cpp2C annotations contain, in which case
+    // the translation unit has no Cpp2C annotations.
+    // Scanning the buffers is much cheaper than walking the AST.
+    // Returns true if any file's contents haven't been loaded, e.g., if the
+    // translation unit was loaded from a serialized AST
+    bool mayContainCpp2CAnnotations(const clang::SourceManager &SM);
+
 } // namespace Utils
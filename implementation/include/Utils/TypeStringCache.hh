@@ -0,0 +1,29 @@
+#pragma once
+
+#include "clang/AST/Type.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Utils
+{
+    // Per-translation unit cache of the printed forms of QualTypes.
+    // The same handful of types are printed for almost every transformed
+    // signature, so each distinct QualType is only printed once
+    class TypeStringCache
+    {
+    private:
+        // Maps the opaque pointer of a QualType to its printed form
+        std::unordered_map<void *, std::string> Strings;
+
+        // Guards the cache, since signatures may be printed from the
+        // parallel analysis phase
+        std::mutex Mutex;
+
+    public:
+        // Returns QT.getAsString(), printing the type only the first time
+        // it is requested
+        std::string getAsString(clang::QualType QT);
+    };
+} // namespace Utils
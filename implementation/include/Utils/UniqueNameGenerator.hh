@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_set>
+
+namespace Utils
+{
+    // Generates the names of transformed definitions.
+    // Names are derived from the original macro and the transformed
+    // signature, so the same transformation is given the same name on
+    // every run. If that name is already taken, a counter is appended
+    // to it until it is unique.
+    // A single generator may be shared by several translation units
+    class UniqueNameGenerator
+    {
+    private:
+        // All the symbols names may not collide with
+        std::unordered_set<std::string> UsedSymbols;
+
+        // Guards the used symbols
+        mutable std::mutex Mutex;
+
+    public:
+        // Marks the given symbol as used
+        void addUsedSymbol(const std::string &Symbol);
+
+        // Marks all the given symbols as used
+        void addUsedSymbols(const std::set<std::string> &Symbols);
+
+        // Returns true if the given symbol is used, false otherwise
+        bool isUsed(const std::string &Symbol) const;
+
+        // Returns a new unique name for the transformation of the macro
+        // with the given name and hash to the given signature,
+        // and marks it as used
+        std::string getUniqueName(
+            const std::string &MacroName,
+            const std::string &MacroHash,
+            const std::string &Signature,
+            bool IsVar);
+    };
+} // namespace Utils
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "clang/AST/RecursiveASTVisitor.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Visitors
+{
+    // Visitor class which measures how abstract a translation unit's code
+    // is, in a single traversal:
+    // - The nesting depth of each top-level expression, i.e., each
+    //   expression that is not a subexpression of another expression.
+    //   Only nested statements and expressions count towards the depth,
+    //   not the declarations and types in them, such as a cast's type.
+    // - The names of all functions and global variables.
+    // - The unique symbols referenced in each function definition and
+    //   global variable initializer.
+    class AbstractionMetricsVisitor
+        : public clang::RecursiveASTVisitor<AbstractionMetricsVisitor>
+    {
+    private:
+        // The number of top-level expressions of each depth
+        std::vector<unsigned> ExpressionDepthCounts;
+
+        std::set<std::string> FunctionAndGlobalNames;
+
+        // Maps the name of each function definition and initialized
+        // global variable to the names of the declarations it references
+        std::map<std::string, std::set<std::string>> UniqueSymbols;
+
+        // For each statement being traversed, the greatest depth of its
+        // children traversed so far, plus one, or zero if it has none yet
+        std::vector<unsigned> Depths;
+
+        // The number of expressions being traversed
+        unsigned ExpressionNesting = 0;
+
+        // Symbols referenced by the function definition or global variable
+        // initializer being traversed, or null if there is none
+        std::set<std::string> *CurrentSymbols = nullptr;
+
+        // Traverses a top-level function or variable, collecting the
+        // symbols it references if Collect is true
+        template <typename TraverseFn>
+        bool traverseTopLevelDecl(
+            clang::NamedDecl *D,
+            bool Collect,
+            TraverseFn Traverse);
+
+    public:
+        // Computes each statement's depth as it is traversed,
+        // so each one is only visited once
+        bool TraverseStmt(clang::Stmt *S, DataRecursionQueue *Queue = nullptr);
+
+        bool TraverseFunctionDecl(clang::FunctionDecl *FD);
+
+        bool TraverseVarDecl(clang::VarDecl *VD);
+
+        bool VisitDeclRefExpr(clang::DeclRefExpr *DRE);
+
+        const std::vector<unsigned> &getExpressionDepthCounts() const;
+
+        const std::set<std::string> &getFunctionAndGlobalNames() const;
+
+        const std::map<std::string, std::set<std::string>> &getUniqueSymbols() const;
+    };
+} // namespace Visitors
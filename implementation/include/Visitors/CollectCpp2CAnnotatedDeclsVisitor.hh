@@ -21,6 +21,10 @@ namespace Visitors
     public:
         explicit CollectCpp2CAnnotatedDeclsVisitor(clang::ASTContext &Ctx);
 
+        // Skips the traversal entirely if no file in the translation unit
+        // contains a Cpp2C annotation
+        bool TraverseTranslationUnitDecl(clang::TranslationUnitDecl *TUD);
+
         // Collect struct/union/enum forward declarations
         // and transformed function declarations
         bool VisitNamedDecl(clang::NamedDecl *D);
@@ -27,5 +27,9 @@ namespace Visitors
         bool VisitFunctionDecl(clang::FunctionDecl *FDecl);
 
         bool VisitVarDecl(clang::VarDecl *VD);
+
+        // Enum constants share the ordinary identifier namespace with
+        // variables, so they are collected as variable names
+        bool VisitEnumConstantDecl(clang::EnumConstantDecl *ECD);
     };
 } // namespace Visitors
\ No newline at end of file
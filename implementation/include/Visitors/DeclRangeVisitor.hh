@@ -9,16 +9,37 @@ namespace Visitors
     class DeclRangeVisitor
         : public clang::RecursiveASTVisitor<DeclRangeVisitor>
     {
-        // Collects source ranges of all decls in the AST
+        // Collects source ranges of all top-level decls in the AST.
+        // Nested decls (parameters, fields, locals, etc.) are always
+        // covered by the range of their enclosing top-level decl,
+        // so we don't traverse into them
     private:
         clang::ASTContext &Ctx;
         std::vector<clang::SourceRange> DeclRanges;
 
+        // Whether DeclRanges has been sorted by beginning location
+        bool Sorted = false;
+
+        // MaxEndIndices[i] is the index of the range with the greatest
+        // end location among DeclRanges[0..i] (once sorted)
+        std::vector<std::size_t> MaxEndIndices;
+
+        // Sorts the collected ranges and computes MaxEndIndices
+        void sortDeclRanges();
+
     public:
         explicit DeclRangeVisitor(clang::ASTContext &Ctx);
-        
-        bool VisitDecl(clang::Decl *D);
-        
+
+        // Records the range of each top-level decl without
+        // traversing its children
+        bool TraverseDecl(clang::Decl *D);
+
         std::vector<clang::SourceRange> &getDeclRangesRef();
+
+        // Returns a pointer to the range of a top-level decl which
+        // contains the given location, or nullptr if there is none.
+        // The first call sorts the collected ranges, after which each
+        // lookup is a binary search
+        const clang::SourceRange *findDeclRangeContaining(clang::SourceLocation Loc);
     };
-} // namespace Visitors
\ No newline at end of file
+} // namespace Visitors
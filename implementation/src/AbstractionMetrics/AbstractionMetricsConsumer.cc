@@ -0,0 +1,25 @@
+#include "AbstractionMetrics/AbstractionMetricsConsumer.hh"
+#include "Visitors/AbstractionMetricsVisitor.hh"
+
+#include "nlohmann/single_include/json.hpp"
+
+namespace AbstractionMetrics
+{
+    void AbstractionMetricsConsumer::HandleTranslationUnit(clang::ASTContext &Ctx)
+    {
+        Visitors::AbstractionMetricsVisitor AMV;
+        AMV.TraverseDecl(Ctx.getTranslationUnitDecl());
+
+        auto &SM = Ctx.getSourceManager();
+        auto MainFile = SM.getFileEntryForID(SM.getMainFileID());
+
+        nlohmann::json j = {
+            {"main file", MainFile ? MainFile->tryGetRealPathName().str() : ""},
+            // The i-th element is the number of top-level expressions
+            // of depth i
+            {"expression depth counts", AMV.getExpressionDepthCounts()},
+            {"function and global names", AMV.getFunctionAndGlobalNames()},
+            {"unique symbols", AMV.getUniqueSymbols()}};
+        llvm::outs() << j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) << '\n';
+    }
+} // namespace AbstractionMetrics
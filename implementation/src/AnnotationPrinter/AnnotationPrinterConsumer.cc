@@ -1,20 +1,115 @@
 #include "AnnotationPrinter/AnnotationPrinterConsumer.hh"
 #include "Visitors/CollectCpp2CAnnotatedDeclsVisitor.hh"
+#include "Utils/AnnotationManifest.hh"
+#include "Utils/AnnotationScanner.hh"
 #include "Utils/TransformedDeclarationAnnotation.hh"
 
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <map>
+
 namespace AnnotationPrinter
 {
 
+    AnnotationPrinterConsumer::AnnotationPrinterConsumer(
+        AnnotationPrinterSettings APSettings) : APSettings(APSettings) {}
+
+    // Prints the given annotations as a JSON array
+    static void printAnnotations(
+        const std::vector<Utils::TransformedDeclarationAnnotation> &TDAs)
+    {
+        llvm::outs() << "[ ";
+        unsigned int i = 0;
+        for (auto &&TDA : TDAs)
+        {
+            if (i > 0)
+            {
+                llvm::outs() << ", ";
+            }
+
+            nlohmann::json j;
+            Utils::to_json(j, TDA);
+            llvm::outs() << j.dump();
+
+            i += 1;
+        }
+        llvm::outs() << " ]";
+    }
+
+    // Returns the annotations in every source file and header in the given
+    // directory, with annotations of the same transformation merged into one
+    // that lists all the files its definition was emitted to.
+    // The files are only lexed, so this is much faster than parsing each
+    // translation unit of the project, and headers are only read once
+    static std::vector<Utils::TransformedDeclarationAnnotation> scanProject(
+        const std::string &Dir,
+        const Utils::AnnotationManifest &Manifest,
+        const clang::LangOptions &LO)
+    {
+        std::map<std::string, Utils::TransformedDeclarationAnnotation> Inventory;
+        for (auto &&File : Utils::collectSourceFiles(Dir))
+        {
+            auto Buffer = llvm::MemoryBuffer::getFile(File);
+            if (!Buffer)
+            {
+                llvm::errs() << "Could not read " << File << '\n';
+                continue;
+            }
+
+            for (auto &&Annotation : Utils::scanCpp2CAnnotations((*Buffer)->getBuffer(), LO))
+            {
+                // Forward declarations of tags have no transformation
+                if (Annotation == "CPP2C")
+                {
+                    continue;
+                }
+
+                Utils::TransformedDeclarationAnnotation TDA;
+                if (!Manifest.lookup(Annotation, TDA))
+                {
+                    llvm::errs() << "Malformed annotation or no manifest entry for it in "
+                                 << File << ": " << Annotation << '\n';
+                    continue;
+                }
+
+                auto Inserted = Inventory.emplace(Utils::hashTDA(TDA), TDA);
+                if (!Inserted.second)
+                {
+                    Inserted.first->second.TransformedDefinitionRealPaths.insert(
+                        TDA.TransformedDefinitionRealPaths.begin(),
+                        TDA.TransformedDefinitionRealPaths.end());
+                }
+            }
+        }
+
+        std::vector<Utils::TransformedDeclarationAnnotation> TDAs;
+        for (auto &&it : Inventory)
+        {
+            TDAs.push_back(it.second);
+        }
+        return TDAs;
+    }
+
     void AnnotationPrinterConsumer::HandleTranslationUnit(clang::ASTContext &Ctx)
     {
+        Utils::AnnotationManifest Manifest;
+        if (APSettings.AnnotationManifestPath != "")
+        {
+            Manifest.load(APSettings.AnnotationManifestPath);
+        }
+
+        if (APSettings.ProjectDir != "")
+        {
+            printAnnotations(scanProject(APSettings.ProjectDir, Manifest, Ctx.getLangOpts()));
+            return;
+        }
+
         auto CADV = Visitors::CollectCpp2CAnnotatedDeclsVisitor(Ctx);
         auto TUD = Ctx.getTranslationUnitDecl();
         CADV.TraverseTranslationUnitDecl(TUD);
         auto &AnnotatedDecls = CADV.getDeclsRef();
 
-        // Print the output as a JSON array
-        llvm::outs() << "[ ";
-        unsigned int i = 0;
+        std::vector<Utils::TransformedDeclarationAnnotation> TDAs;
         for (auto &&D : AnnotatedDecls)
         {
             // Only consider var and func decls, not tag decls
@@ -23,18 +118,16 @@ namespace AnnotationPrinter
                 continue;
             }
 
-            if (i > 0)
+            std::string annotation = Utils::getFirstAnnotationOrEmpty(D);
+            Utils::TransformedDeclarationAnnotation TDA;
+            if (!Manifest.lookup(annotation, TDA))
             {
-                llvm::outs() << ", ";
+                llvm::errs() << "Malformed annotation or no manifest entry for it: " << annotation << '\n';
+                continue;
             }
-
-            std::string annotation = Utils::getFirstAnnotationOrEmpty(D);
-            nlohmann::json j = Utils::annotationStringToJson(annotation);
-            llvm::outs() << j.dump();
-
-            i += 1;
+            TDAs.push_back(TDA);
         }
-        llvm::outs() << " ]";
+        printAnnotations(TDAs);
     }
 
 } // namespace AnnotationPrinter
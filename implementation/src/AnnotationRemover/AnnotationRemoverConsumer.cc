@@ -1,7 +1,15 @@
 #include "AnnotationRemover/AnnotationRemoverConsumer.hh"
 #include "Visitors/CollectCpp2CAnnotatedDeclsVisitor.hh"
+#include "Utils/EditList.hh"
+#include "Utils/TransformedDeclarationAnnotation.hh"
 
-#include "clang/Rewrite/Core/Rewriter.h"
+#include "clang/Lex/Lexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <string>
+#include <utility>
 
 namespace AnnotationRemover
 {
@@ -9,6 +17,80 @@ namespace AnnotationRemover
     AnnotationRemoverConsumer::AnnotationRemoverConsumer(
         AnnotationRemoverSettings ARSettings) : ARSettings(ARSettings) {}
 
+    // Given the offsets of an annotate(...) attribute in Buffer, widens them
+    // to cover the __attribute__((...)) around it and the whitespace before
+    // that, if the annotation is the only attribute in it.
+    // Otherwise leaves them as they are, since an empty attribute list is
+    // still valid
+    static void widenToAttributeSpecifier(
+        llvm::StringRef Buffer,
+        unsigned &Begin,
+        unsigned &End)
+    {
+        auto skipSpaceBackward = [&](unsigned i)
+        {
+            while (i > 0 && std::isspace(static_cast<unsigned char>(Buffer[i - 1])))
+            {
+                i--;
+            }
+            return i;
+        };
+        auto skipSpaceForward = [&](unsigned i)
+        {
+            while (i < Buffer.size() && std::isspace(static_cast<unsigned char>(Buffer[i])))
+            {
+                i++;
+            }
+            return i;
+        };
+
+        // Look for "__attribute__ ( (" before the annotation
+        unsigned B = Begin;
+        for (int Parens = 0; Parens < 2; Parens++)
+        {
+            B = skipSpaceBackward(B);
+            if (B == 0 || Buffer[B - 1] != '(')
+            {
+                return;
+            }
+            B--;
+        }
+        B = skipSpaceBackward(B);
+        llvm::StringRef Keyword = "__attribute__";
+        if (B < Keyword.size() || !Buffer.substr(B - Keyword.size(), Keyword.size()).equals(Keyword))
+        {
+            return;
+        }
+        B -= Keyword.size();
+
+        // Look for ") )" after it
+        unsigned E = End;
+        for (int Parens = 0; Parens < 2; Parens++)
+        {
+            E = skipSpaceForward(E);
+            if (E == Buffer.size() || Buffer[E] != ')')
+            {
+                return;
+            }
+            E++;
+        }
+
+        // Remove the whitespace that separated the attribute from the
+        // rest of the declaration along with it
+        Begin = skipSpaceBackward(B);
+        End = E;
+    }
+
+    // Reports that the annotations could not be removed as a compiler
+    // error, so that the process fails instead of looking like it
+    // succeeded
+    static void reportFailure(clang::ASTContext &Ctx, const std::string &Msg)
+    {
+        clang::DiagnosticsEngine &DE = Ctx.getDiagnostics();
+        unsigned ID = DE.getCustomDiagID(clang::DiagnosticsEngine::Error, "cpp2c: %0");
+        DE.Report(ID) << Msg;
+    }
+
     void AnnotationRemoverConsumer::HandleTranslationUnit(clang::ASTContext &Ctx)
     {
         auto TUD = Ctx.getTranslationUnitDecl();
@@ -17,36 +99,78 @@ namespace AnnotationRemover
 
         auto &SM = Ctx.getSourceManager();
         auto &LO = Ctx.getLangOpts();
-        clang::Rewriter RW(SM, LO);
+        Utils::EditList Edits(SM, LO);
+        // Redeclarations inherit their previous declarations' attributes,
+        // so only remove each annotation once
+        std::set<std::pair<clang::FileID, unsigned>> Removed;
         for (auto D : DAC.getDeclsRef())
         {
-            // Get the range the decl originally covered
-            auto ReplacementRange = SM.getExpansionRange(D->getSourceRange());
-            // Remove all its attributes
-            D->dropAttrs();
-            // Print the new decl to a string
-            std::string S;
-            llvm::raw_string_ostream SS(S);
-            D->print(SS);
-            // Rewrite the old decl with the new one
-            auto failed = RW.ReplaceText(ReplacementRange, SS.str());
-            if (failed)
+            for (auto &&A : D->specific_attrs<clang::AnnotateAttr>())
             {
-                llvm::errs() << "Failed to remove attribute range: ";
-                ReplacementRange.getAsRange().dump(SM);
+                if (A->isInherited() || !Utils::isCpp2CAnnotation(A->getAnnotation()))
+                {
+                    continue;
+                }
+
+                // The range spans from annotate to its closing parenthesis
+                auto Range = A->getRange();
+                if (!Range.getBegin().isFileID() || !Range.getEnd().isFileID())
+                {
+                    llvm::errs() << "Failed to remove attribute range: ";
+                    Range.dump(SM);
+                    continue;
+                }
+                auto BeginLoc = SM.getDecomposedLoc(Range.getBegin());
+                auto EndLoc = SM.getDecomposedLoc(Range.getEnd());
+                if (!Removed.insert(BeginLoc).second)
+                {
+                    continue;
+                }
+
+                unsigned Begin = BeginLoc.second;
+                unsigned End = EndLoc.second +
+                               clang::Lexer::MeasureTokenLength(Range.getEnd(), SM, LO);
+                widenToAttributeSpecifier(SM.getBufferData(BeginLoc.first), Begin, End);
+
+                auto FileStart = SM.getLocForStartOfFile(BeginLoc.first);
+                auto failed = Edits.removeText(FileStart.getLocWithOffset(Begin),
+                                               FileStart.getLocWithOffset(End));
+                if (failed)
+                {
+                    llvm::errs() << "Failed to remove attribute range: ";
+                    Range.dump(SM);
+                }
             }
         }
 
-        if (ARSettings.OverwriteFiles)
+        std::string Err;
+        if (!Edits.validate(Err))
         {
-            RW.overwriteChangedFiles();
+            reportFailure(Ctx, "could not apply edits: " + Err);
+            return;
+        }
+
+        if (ARSettings.OverwriteFiles && ARSettings.HeaderEditsDir != "")
+        {
+            if (Edits.overwriteMainFileAndRecordOthers(ARSettings.HeaderEditsDir))
+            {
+                reportFailure(Ctx, "could not write the files without annotations");
+            }
+        }
+        else if (ARSettings.OverwriteFiles)
+        {
+            if (Edits.overwriteChangedFiles())
+            {
+                reportFailure(Ctx, "could not write the files without annotations");
+            }
         }
         else
         {
             // Print the results of the rewriting for the current file
-            if (auto RewriteBuf = RW.getRewriteBufferFor(SM.getMainFileID()))
+            auto Edited = Edits.getEditedFiles();
+            if (std::find(Edited.begin(), Edited.end(), SM.getMainFileID()) != Edited.end())
             {
-                RewriteBuf->write(llvm::outs());
+                llvm::outs() << Edits.getRewrittenBuffer(SM.getMainFileID());
             }
             else
             {
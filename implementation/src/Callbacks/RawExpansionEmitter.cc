@@ -0,0 +1,39 @@
+#include "Callbacks/RawExpansionEmitter.hh"
+#include "Utils/Logging/TransformerMessages.hh"
+
+namespace Callbacks
+{
+    using namespace clang;
+
+    RawExpansionEmitter::RawExpansionEmitter(
+        Preprocessor &PP,
+        SourceManager &SM)
+        : PP(PP),
+          SM(SM){};
+
+    void RawExpansionEmitter::MacroExpands(
+        const Token &MacroNameTok,
+        const MacroDefinition &MD,
+        SourceRange Range,
+        const MacroArgs *Args)
+    {
+        std::string MacroName = MacroNameTok.getIdentifierInfo()->getName().str();
+        Utils::Logging::emitRawMacroExpansionMessage(
+            llvm::errs(),
+            Utils::Logging::hashExpandedMacro(MacroName, MD, SM),
+            SM.getSpellingLoc(Range.getBegin()),
+            SM);
+
+        // The MacroForest pre-expands every argument, which expands the
+        // macros in arguments that are only stringified or pasted too,
+        // so do the same to emit the same messages.
+        // Pre-expansions are cached, so this doesn't expand them twice
+        if (Args)
+        {
+            for (unsigned i = 0; i < Args->getNumMacroArguments(); i++)
+            {
+                const_cast<MacroArgs *>(Args)->getPreExpArgument(i, PP);
+            }
+        }
+    }
+} // namespace Callbacks
@@ -1,4 +1,5 @@
 #include "Cpp2C/Cpp2CAction.hh"
+#include "MacroCounter/MacroCounterAction.hh"
 
 #include "clang/Frontend/FrontendPluginRegistry.h"
 
@@ -11,3 +12,8 @@ using clang::FrontendPluginRegistry;
 // consumer to use
 static FrontendPluginRegistry::Add<Cpp2C::Cpp2CAction>
     X("cpp2c", "Transform CPP macros to C functions");
+
+// Counting only runs the preprocessor, so it replaces Clang's main action
+// and can't be a command of the cpp2c plugin
+static FrontendPluginRegistry::Add<MacroCounter::MacroCounterAction>
+    Y("cpp2c-count", "Count macro definitions and expansions without parsing");
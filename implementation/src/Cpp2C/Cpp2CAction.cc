@@ -1,14 +1,16 @@
 #include "Cpp2C/Cpp2CAction.hh"
+#include "Transformer/FixedPointDriver.hh"
 #include "Transformer/TransformerConsumer.hh"
 #include "AnnotationRemover/AnnotationRemoverConsumer.hh"
 #include "AnnotationPrinter/AnnotationPrinterConsumer.hh"
+#include "AbstractionMetrics/AbstractionMetricsConsumer.hh"
 
 namespace Cpp2C
 {
     using namespace std;
     using namespace clang;
 
-    string USAGE_STRING = "USAGE: cpp2c (transform|tr [((-i|--in-place)|(-dd|--deduplicate)|(-v|--verbose)|(-shm|--standard-header-macros)|(-tce|--transform-conditional-evaluation))*])|(print_annotations|pa)|(remove_annotations|ra [-i|--in-place]) FILE_NAME";
+    string USAGE_STRING = "USAGE: cpp2c (transform|tr [((-i|--in-place)|(-dd|--deduplicate)|(-cdd|--content-deduplicate)|(-v|--verbose)|(-shm|--standard-header-macros)|(-tce|--transform-conditional-evaluation)|(-fp|--fixed-point)|(--verdict-cache=FILE)|(--jobs=N)|(--emit=(replacements|patch))|(--inline=(hint|always))|(--constants=(const|enum))|(--header-edits=DIR)|(--annotation-manifest=FILE)|(--expansion-budget=MS)|(--tu-budget=MS))*])|(print_annotations|pa [((--annotation-manifest=FILE)|(--project=DIR))*])|(remove_annotations|ra [((-i|--in-place)|(--header-edits=DIR))*])|(abstraction_metrics|am)|(count) FILE_NAME";
 
     unique_ptr<ASTConsumer>
     Cpp2CAction::CreateASTConsumer(
@@ -37,9 +39,14 @@ namespace Cpp2C
         }
         else if (Command == PRINT_ANNOTATIONS)
         {
-            auto AP = make_unique<AnnotationPrinter::AnnotationPrinterConsumer>();
+            auto AP = make_unique<AnnotationPrinter::AnnotationPrinterConsumer>(APSettings);
             return AP;
         }
+        else if (Command == ABSTRACTION_METRICS)
+        {
+            auto AM = make_unique<AbstractionMetrics::AbstractionMetricsConsumer>();
+            return AM;
+        }
         llvm::errs() << "No command passed\n";
         exit(1);
     }
@@ -52,6 +59,13 @@ namespace Cpp2C
         // First argument is the command
         // Rest are optional arguments for that command
 
+        // Iterations of the fixed-point driver run their own transformer,
+        // so don't add the plugin to them
+        if (Transformer::FixedPointDriver::isRunning())
+        {
+            return false;
+        }
+
         // Check that the user passed a required command
         if (args.size() == 0)
         {
@@ -80,6 +94,10 @@ namespace Cpp2C
                 {
                     TSettings.DeduplicateWhileTransforming = true;
                 }
+                else if (arg == "-cdd" || arg == "--content-deduplicate")
+                {
+                    TSettings.DeduplicateByContent = true;
+                }
                 else if (arg == "-v" || arg == "--verbose")
                 {
                     TSettings.Verbose = true;
@@ -92,18 +110,141 @@ namespace Cpp2C
                 {
                     TSettings.TransformConditionalEvaluation = true;
                 }
+                else if (arg == "-fp" || arg == "--fixed-point")
+                {
+                    TSettings.FixedPoint = true;
+                }
+                else if (arg.rfind("--verdict-cache=", 0) == 0)
+                {
+                    TSettings.VerdictCachePath = arg.substr(string("--verdict-cache=").length());
+                }
+                else if (arg.rfind("--jobs=", 0) == 0)
+                {
+                    llvm::StringRef Jobs(arg.substr(string("--jobs=").length()));
+                    if (Jobs.getAsInteger(10, TSettings.Jobs))
+                    {
+                        llvm::errs() << "Invalid number of jobs: " << Jobs << '\n';
+                        exit(1);
+                    }
+                }
+                else if (arg.rfind("--annotation-manifest=", 0) == 0)
+                {
+                    TSettings.AnnotationManifestPath = arg.substr(string("--annotation-manifest=").length());
+                }
+                else if (arg.rfind("--expansion-budget=", 0) == 0)
+                {
+                    llvm::StringRef Budget(arg.substr(string("--expansion-budget=").length()));
+                    if (Budget.getAsInteger(10, TSettings.ExpansionBudgetMs))
+                    {
+                        llvm::errs() << "Invalid expansion budget: " << Budget << '\n';
+                        exit(1);
+                    }
+                }
+                else if (arg.rfind("--tu-budget=", 0) == 0)
+                {
+                    llvm::StringRef Budget(arg.substr(string("--tu-budget=").length()));
+                    if (Budget.getAsInteger(10, TSettings.TUBudgetMs))
+                    {
+                        llvm::errs() << "Invalid translation unit budget: " << Budget << '\n';
+                        exit(1);
+                    }
+                    TSettings.HasTUBudget = true;
+                }
+                else if (arg.rfind("--header-edits=", 0) == 0)
+                {
+                    TSettings.HeaderEditsDir = arg.substr(string("--header-edits=").length());
+                }
+                else if (arg.rfind("--inline=", 0) == 0)
+                {
+                    string Inline = arg.substr(string("--inline=").length());
+                    if (Inline == "hint")
+                    {
+                        TSettings.InlineMode = Transformer::INLINE_HINT;
+                    }
+                    else if (Inline == "always")
+                    {
+                        TSettings.InlineMode = Transformer::INLINE_ALWAYS;
+                    }
+                    else
+                    {
+                        llvm::errs() << "Unknown inline mode: " << Inline << '\n';
+                        exit(1);
+                    }
+                }
+                else if (arg.rfind("--constants=", 0) == 0)
+                {
+                    string Constants = arg.substr(string("--constants=").length());
+                    if (Constants == "const")
+                    {
+                        TSettings.ConstantMode = Transformer::CONSTANTS_CONST;
+                    }
+                    else if (Constants == "enum")
+                    {
+                        TSettings.ConstantMode = Transformer::CONSTANTS_ENUM;
+                    }
+                    else
+                    {
+                        llvm::errs() << "Unknown constant mode: " << Constants << '\n';
+                        exit(1);
+                    }
+                }
+                else if (arg.rfind("--emit=", 0) == 0)
+                {
+                    string Emit = arg.substr(string("--emit=").length());
+                    if (Emit == "replacements")
+                    {
+                        TSettings.EmitMode = Transformer::EMIT_REPLACEMENTS;
+                    }
+                    else if (Emit == "patch")
+                    {
+                        TSettings.EmitMode = Transformer::EMIT_PATCH;
+                    }
+                    else
+                    {
+                        llvm::errs() << "Unknown emit mode: " << Emit << '\n';
+                        exit(1);
+                    }
+                }
                 else
                 {
                     llvm::errs() << "Unknown transformer argument: " << arg << '\n';
                     exit(1);
                 }
             }
+
+            // The fixed-point driver only has the final contents of each
+            // file, not the edits that led to them, so it can only print
+            // the main file or overwrite the files
+            if (TSettings.FixedPoint &&
+                (TSettings.EmitMode != Transformer::EMIT_FILES ||
+                 TSettings.HeaderEditsDir != ""))
+            {
+                llvm::errs() << "-fp can't be combined with --emit or --header-edits\n";
+                exit(1);
+            }
         }
 
         // Print annotations
         else if (command == "pa" || command == "print_annotations")
         {
             Command = PRINT_ANNOTATIONS;
+            for (auto it = optionalArgs; it != args.end(); ++it)
+            {
+                std::string arg = *it;
+                if (arg.rfind("--annotation-manifest=", 0) == 0)
+                {
+                    APSettings.AnnotationManifestPath = arg.substr(string("--annotation-manifest=").length());
+                }
+                else if (arg.rfind("--project=", 0) == 0)
+                {
+                    APSettings.ProjectDir = arg.substr(string("--project=").length());
+                }
+                else
+                {
+                    llvm::errs() << "Unknown annotation printer argument: " << arg << '\n';
+                    exit(1);
+                }
+            }
         }
 
         // Remove annotations
@@ -117,6 +258,10 @@ namespace Cpp2C
                 {
                     ARSettings.OverwriteFiles = true;
                 }
+                else if (arg.rfind("--header-edits=", 0) == 0)
+                {
+                    ARSettings.HeaderEditsDir = arg.substr(string("--header-edits=").length());
+                }
                 else
                 {
                     llvm::errs() << "Unknown annotation remover argument: " << arg << '\n';
@@ -125,6 +270,17 @@ namespace Cpp2C
             }
         }
 
+        // Abstraction metrics
+        else if (command == "am" || command == "abstraction_metrics")
+        {
+            Command = ABSTRACTION_METRICS;
+            for (auto it = optionalArgs; it != args.end(); ++it)
+            {
+                llvm::errs() << "Unknown abstraction metrics argument: " << *it << '\n';
+                exit(1);
+            }
+        }
+
         // No valid command passed
         else
         {
@@ -132,9 +288,28 @@ namespace Cpp2C
             return false;
         }
 
+        // The other commands only need the AST, which Clang loads from a
+        // serialized AST without parsing anything. The transformer needs
+        // every expansion and the tokens of its arguments, which are only
+        // available while preprocessing; a serialized preprocessing record
+        // doesn't keep expansions nested in macro definitions or any
+        // argument tokens
+        if (Command == TRANSFORM && isASTInput(CI))
+        {
+            llvm::errs() << "Cannot transform a serialized AST; pass the source file instead\n";
+            exit(1);
+        }
+
         return true;
     }
 
+    bool Cpp2CAction::isASTInput(const CompilerInstance &CI)
+    {
+        auto &Inputs = CI.getFrontendOpts().Inputs;
+        return !Inputs.empty() &&
+               Inputs.front().getKind().getFormat() == InputKind::Precompiled;
+    }
+
     // Necessary for ANYTHING to print to stderr
     PluginASTAction::ActionType Cpp2CAction::getActionType()
     {
@@ -114,23 +114,30 @@ namespace CppSig
     {
         for (auto ToplevelExpansion : ExpansionRoots)
         {
-            for (auto Expansion : ToplevelExpansion->getSubtreeNodesRef())
-            {
-                for (auto ST : Expansion->getStmtsRef())
-                { // most of the time only a single one.
-                    for (auto &Arg : Expansion->getArgumentsRef())
-                    {
-                        auto MatcherArg = stmt(
-                                              unless(implicitCastExpr()),
-                                              inSourceRangeCollection(Arg.getTokenRangesPtr()))
-                                              .bind("stmt");
-                        auto Matcher = stmt(forEachDescendant(MatcherArg));
-                        MatchFinder ArgumentFinder;
-                        Callbacks::ForestCollector callback(Ctx, Arg.getStmtsRef());
-                        ArgumentFinder.addMatcher(MatcherArg, &callback);
-                        ArgumentFinder.addMatcher(Matcher, &callback);
-                        ArgumentFinder.match(*ST, Ctx);
-                    }
+            matchArguments(Ctx, ToplevelExpansion);
+        }
+    }
+
+    void matchArguments(
+        ASTContext &Ctx,
+        MacroExpansionNode *ToplevelExpansion)
+    {
+        for (auto Expansion : ToplevelExpansion->getSubtreeNodesRef())
+        {
+            for (auto ST : Expansion->getStmtsRef())
+            { // most of the time only a single one.
+                for (auto &Arg : Expansion->getArgumentsRef())
+                {
+                    auto MatcherArg = stmt(
+                                          unless(implicitCastExpr()),
+                                          inSourceRangeCollection(Arg.getTokenRangesPtr()))
+                                          .bind("stmt");
+                    auto Matcher = stmt(forEachDescendant(MatcherArg));
+                    MatchFinder ArgumentFinder;
+                    Callbacks::ForestCollector callback(Ctx, Arg.getStmtsRef());
+                    ArgumentFinder.addMatcher(MatcherArg, &callback);
+                    ArgumentFinder.addMatcher(Matcher, &callback);
+                    ArgumentFinder.match(*ST, Ctx);
                 }
             }
         }
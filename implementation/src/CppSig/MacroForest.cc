@@ -68,19 +68,12 @@ namespace CppSig
         Expansion->DefinitionNumber = Utils::countMacroDefinitions(SM, MD);
 
         // Record this macro's hash
-        std::string MacroType = MI->isObjectLike() ? "object-like" : "function-like";
-        std::string DefinitionFileRealPath = Utils::fileRealPathOrEmpty(SM, DefinitionRange.getBegin());
-        Expansion->MacroHash = Expansion->Name + ';' +
-                               MacroType + ';' +
-                               DefinitionFileRealPath + ';' +
-                               std::to_string(Expansion->DefinitionNumber);
+        Expansion->MacroHash = Utils::Logging::hashExpandedMacro(Expansion->Name, MD, SM);
 
         if (Verbose)
         {
-            llvm::errs() << "CPP2C:Raw Macro Expansion\t"
-                         << Expansion->MacroHash << "\t"
-                         << SpellingRange.getBegin().printToString(SM) 
-                         << "\n";
+            Utils::Logging::emitRawMacroExpansionMessage(
+                llvm::errs(), Expansion->MacroHash, SpellingRange.getBegin(), SM);
         }
 
         // Record the raw text of the macro definition
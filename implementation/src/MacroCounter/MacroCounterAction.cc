@@ -0,0 +1,74 @@
+#include "MacroCounter/MacroCounterAction.hh"
+#include "Cpp2C/Cpp2CAction.hh"
+#include "Callbacks/MacroNameCollector.hh"
+#include "Callbacks/RawExpansionEmitter.hh"
+
+#include "clang/Lex/Preprocessor.h"
+
+namespace MacroCounter
+{
+    using namespace std;
+    using namespace clang;
+
+    unique_ptr<ASTConsumer>
+    MacroCounterAction::CreateASTConsumer(
+        CompilerInstance &CI,
+        StringRef file)
+    {
+        return make_unique<ASTConsumer>();
+    }
+
+    bool MacroCounterAction::ParseArgs(
+        const CompilerInstance &CI,
+        const vector<string> &args)
+    {
+        for (auto &&arg : args)
+        {
+            llvm::errs() << "Unknown macro counter argument: " << arg << '\n';
+            exit(1);
+        }
+        // A serialized preprocessing record doesn't keep expansions nested
+        // in macro definitions, so the counts would be wrong
+        if (Cpp2C::Cpp2CAction::isASTInput(CI))
+        {
+            llvm::errs() << "Cannot count the macros in a serialized AST; pass the source file instead\n";
+            exit(1);
+        }
+        return true;
+    }
+
+    PluginASTAction::ActionType MacroCounterAction::getActionType()
+    {
+        return ActionType::ReplaceAction;
+    }
+
+    bool MacroCounterAction::usesPreprocessorOnly() const
+    {
+        return true;
+    }
+
+    void MacroCounterAction::ExecuteAction()
+    {
+        CompilerInstance &CI = getCompilerInstance();
+        Preprocessor &PP = CI.getPreprocessor();
+        SourceManager &SM = CI.getSourceManager();
+
+        // The same callbacks emit these messages while transforming
+        PP.addPPCallbacks(make_unique<Callbacks::MacroNameCollector>(
+            MacroNames,
+            MultiplyDefinedMacros,
+            true,
+            SM,
+            CI.getLangOpts()));
+        PP.addPPCallbacks(make_unique<Callbacks::RawExpansionEmitter>(PP, SM));
+
+        // Lex the whole translation unit, like PreprocessOnlyAction
+        PP.IgnorePragmas();
+        PP.EnterMainSourceFile();
+        Token Tok;
+        do
+        {
+            PP.Lex(Tok);
+        } while (Tok.isNot(tok::eof));
+    }
+} // namespace MacroCounter
@@ -0,0 +1,703 @@
+#include "Summarizer/EventSummary.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace Summarizer
+{
+    static const std::string EVENT_PREFIX = "CPP2C:";
+    static const std::string TRANSLATION_UNIT_HEADER = "CPP2C:Translation Unit";
+    static const std::string COUNT_PHASE = "count";
+    static const std::string TRANSFORM_PHASE = "transform";
+
+    static const std::string OLM_TAG = "object-like";
+    static const std::string FLM_TAG = "function-like";
+
+    // The categories of the reasons cpp2c reports for not transforming an
+    // expansion (see PropertyPipeline.cc), in the order they are printed
+    static const std::vector<std::string> CATEGORIES_NOT_TRANSFORMED = {
+        "Syntactic well-formedness",
+        "Environment capture",
+        "Parameter side-effects",
+        "Unsupported construct",
+        "Turned off construct",
+        "Time budget exceeded"};
+
+    unsigned StringPool::intern(const std::string &S)
+    {
+        auto Inserted = IDs.emplace(S, Strings.size());
+        if (Inserted.second)
+        {
+            Strings.push_back(S);
+        }
+        return Inserted.first->second;
+    }
+
+    const std::string &StringPool::get(unsigned ID) const
+    {
+        return Strings[ID];
+    }
+
+    static std::vector<std::string> split(const std::string &S, char Delim)
+    {
+        std::vector<std::string> Parts;
+        std::size_t Begin = 0;
+        while (true)
+        {
+            auto End = S.find(Delim, Begin);
+            Parts.push_back(S.substr(Begin, End - Begin));
+            if (End == std::string::npos)
+            {
+                return Parts;
+            }
+            Begin = End + 1;
+        }
+    }
+
+    // 64-bit FNV-1a, which is the same on every platform, so that shards
+    // written on different machines can be merged
+    static std::uint64_t hashString(const std::string &S)
+    {
+        std::uint64_t H = 14695981039346656037ULL;
+        for (unsigned char C : S)
+        {
+            H ^= C;
+            H *= 1099511628211ULL;
+        }
+        return H;
+    }
+
+    // Returns true if the given path is that of a system header, or of no
+    // file at all
+    static bool isSystemHeaderPath(const std::string &Path)
+    {
+        return Path.empty() ||
+               Path.find("/usr/include") != std::string::npos ||
+               Path.find("/usr/lib") != std::string::npos ||
+               Path.find("<scratch space>") != std::string::npos;
+    }
+
+    // Returns true if the macro with the given hash was defined in the
+    // source program
+    static bool isSourceMacro(const std::string &MHash)
+    {
+        auto Parts = split(MHash, ';');
+        return Parts.size() == 4 && !isSystemHeaderPath(Parts[2]);
+    }
+
+    void EventSummary::addEvent(
+        const std::string &Phase,
+        unsigned File,
+        const std::vector<std::string> &Fields)
+    {
+        const auto &Kind = Fields[0];
+        if (Phase == COUNT_PHASE)
+        {
+            if (Kind == "CPP2C:Macro Definition" && Fields.size() == 3)
+            {
+                if (isSourceMacro(Fields[1]))
+                {
+                    SourceMacroDefinitions.insert(Macros.intern(Fields[1]));
+                }
+            }
+            else if (Kind == "CPP2C:Raw Macro Expansion" && Fields.size() == 3)
+            {
+                if (isSourceMacro(Fields[1]))
+                {
+                    RawExpansionSpellingLocations[Macros.intern(Fields[1])].insert(hashString(Fields[2]));
+                }
+            }
+            return;
+        }
+
+        if (Kind == "CPP2C:Potentially Transformable Macro Expansion" && Fields.size() == 3)
+        {
+            PotentiallyTransformableMacroRawSigs[Macros.intern(Fields[1])].insert(Names.intern(Fields[2]));
+        }
+        else if (Kind == "CPP2C:Transformed Expansion" && Fields.size() == 6)
+        {
+            auto MHash = Macros.intern(Fields[1]);
+            auto TransformedName = Names.intern(Fields[2]);
+            auto ContainingName = Names.intern(Fields[3]);
+            TransformedDefToVisit.emplace(MHash, TransformedName);
+            TransformedMacros.insert(MHash);
+            TransformedTypes[MHash].insert(Names.intern(Fields[4]));
+            TransformedDeclNames.insert(TransformedName);
+            TransformedInvocations[{File, ContainingName}][MHash] += 1;
+            if (Fields[5] == "var")
+            {
+                MacrosTransformedToVars.insert(MHash);
+            }
+        }
+        else if (Kind == "CPP2C:Untransformed Expansion" && Fields.size() >= 3)
+        {
+            CategoriesNotTransformed[Macros.intern(Fields[1])].insert(Names.intern(Fields[2]));
+        }
+    }
+
+    bool EventSummary::addRecords(std::istream &IS, std::string &Err)
+    {
+        std::string Line;
+        std::string Phase;
+        unsigned File = 0;
+        bool Crashed = false;
+        unsigned LineNumber = 0;
+        while (std::getline(IS, Line))
+        {
+            LineNumber += 1;
+            if (Line.compare(0, TRANSLATION_UNIT_HEADER.size(), TRANSLATION_UNIT_HEADER) == 0)
+            {
+                auto Fields = split(Line, '\t');
+                if (Fields.size() != 5 ||
+                    (Fields[1] != COUNT_PHASE && Fields[1] != TRANSFORM_PHASE))
+                {
+                    Err = "Malformed translation unit header on line " + std::to_string(LineNumber);
+                    return false;
+                }
+                Phase = Fields[1];
+                File = Files.intern(Fields[3]);
+                Crashed = false;
+                if (Phase == TRANSFORM_PHASE)
+                {
+                    RunsToFixedPoint = std::max(RunsToFixedPoint, (unsigned)std::stoul(Fields[2]));
+                    auto Seconds = std::strtod(Fields[4].c_str(), nullptr);
+                    auto Inserted = FileTransformSeconds.emplace(File, std::make_pair(Seconds, Seconds));
+                    if (!Inserted.second)
+                    {
+                        auto &Times = Inserted.first->second;
+                        Times.first = std::max(Times.first, Seconds);
+                        Times.second += Seconds;
+                    }
+                }
+                continue;
+            }
+
+            if (Phase.empty())
+            {
+                continue;
+            }
+            // Check if Clang crashed
+            if (Line.find("PLEASE") != std::string::npos)
+            {
+                Crashes += !Crashed;
+                Crashed = true;
+            }
+            else if (Line.compare(0, EVENT_PREFIX.size(), EVENT_PREFIX) == 0)
+            {
+                addEvent(Phase, File, split(Line, '\t'));
+            }
+        }
+        return true;
+    }
+
+    bool EventSummary::addShard(const nlohmann::json &Shard, std::string &Err)
+    {
+        try
+        {
+            Crashes += Shard.at("crashes").get<unsigned>();
+            for (auto &&MHash : Shard.at("source macro definitions"))
+            {
+                SourceMacroDefinitions.insert(Macros.intern(MHash));
+            }
+            for (auto &&Entry : Shard.at("raw expansion spelling locations"))
+            {
+                auto &Locations = RawExpansionSpellingLocations[Macros.intern(Entry.at(0))];
+                for (auto &&H : Entry.at(1))
+                {
+                    Locations.insert(H.get<std::uint64_t>());
+                }
+            }
+
+            RunsToFixedPoint = std::max(RunsToFixedPoint, Shard.at("runs to fixed point").get<unsigned>());
+            for (auto &&Entry : Shard.at("potentially transformable macros"))
+            {
+                auto &Sigs = PotentiallyTransformableMacroRawSigs[Macros.intern(Entry.at(0))];
+                for (auto &&Sig : Entry.at(1))
+                {
+                    Sigs.insert(Names.intern(Sig));
+                }
+            }
+            for (auto &&Entry : Shard.at("file transform seconds"))
+            {
+                double Max = Entry.at(1), Sum = Entry.at(2);
+                auto Inserted = FileTransformSeconds.emplace(Files.intern(Entry.at(0)), std::make_pair(Max, Sum));
+                if (!Inserted.second)
+                {
+                    auto &Times = Inserted.first->second;
+                    Times.first = std::max(Times.first, Max);
+                    Times.second += Sum;
+                }
+            }
+            for (auto &&Entry : Shard.at("categories not transformed"))
+            {
+                auto &Cats = CategoriesNotTransformed[Macros.intern(Entry.at(0))];
+                for (auto &&Cat : Entry.at(1))
+                {
+                    Cats.insert(Names.intern(Cat));
+                }
+            }
+            for (auto &&Name : Shard.at("transformed decl names"))
+            {
+                TransformedDeclNames.insert(Names.intern(Name));
+            }
+            for (auto &&MHash : Shard.at("transformed macros"))
+            {
+                TransformedMacros.insert(Macros.intern(MHash));
+            }
+            // Earlier shards take precedence
+            for (auto &&Entry : Shard.at("transformed definitions to visit"))
+            {
+                TransformedDefToVisit.emplace(Macros.intern(Entry.at(0)), Names.intern(Entry.at(1)));
+            }
+            for (auto &&Entry : Shard.at("transformed invocations"))
+            {
+                auto File = Files.intern(Entry.at(0));
+                auto Containing = Names.intern(Entry.at(1));
+                TransformedInvocations[{File, Containing}][Macros.intern(Entry.at(2))] += Entry.at(3).get<unsigned>();
+            }
+            for (auto &&Entry : Shard.at("transformed types"))
+            {
+                auto &Types = TransformedTypes[Macros.intern(Entry.at(0))];
+                for (auto &&Ty : Entry.at(1))
+                {
+                    Types.insert(Names.intern(Ty));
+                }
+            }
+            for (auto &&MHash : Shard.at("macros transformed to vars"))
+            {
+                MacrosTransformedToVars.insert(Macros.intern(MHash));
+            }
+        }
+        catch (const nlohmann::json::exception &E)
+        {
+            Err = E.what();
+            return false;
+        }
+        return true;
+    }
+
+    nlohmann::json EventSummary::toShard() const
+    {
+        // Maps are stored as arrays of entries, in the order their keys
+        // were first seen, since that order matters when shards are merged
+        auto macros = [&](const std::set<unsigned> &IDs)
+        {
+            nlohmann::json j = nlohmann::json::array();
+            for (auto ID : IDs)
+            {
+                j.push_back(Macros.get(ID));
+            }
+            return j;
+        };
+        auto names = [&](const std::set<unsigned> &IDs)
+        {
+            nlohmann::json j = nlohmann::json::array();
+            for (auto ID : IDs)
+            {
+                j.push_back(Names.get(ID));
+            }
+            return j;
+        };
+        auto macrosToNames = [&](const std::map<unsigned, std::set<unsigned>> &M)
+        {
+            nlohmann::json j = nlohmann::json::array();
+            for (auto &&it : M)
+            {
+                j.push_back({Macros.get(it.first), names(it.second)});
+            }
+            return j;
+        };
+
+        nlohmann::json Shard;
+        Shard["crashes"] = Crashes;
+        Shard["source macro definitions"] = macros(SourceMacroDefinitions);
+        Shard["raw expansion spelling locations"] = nlohmann::json::array();
+        for (auto &&it : RawExpansionSpellingLocations)
+        {
+            Shard["raw expansion spelling locations"].push_back({Macros.get(it.first), it.second});
+        }
+        Shard["runs to fixed point"] = RunsToFixedPoint;
+        Shard["potentially transformable macros"] = macrosToNames(PotentiallyTransformableMacroRawSigs);
+        Shard["file transform seconds"] = nlohmann::json::array();
+        for (auto &&it : FileTransformSeconds)
+        {
+            Shard["file transform seconds"].push_back({Files.get(it.first), it.second.first, it.second.second});
+        }
+        Shard["categories not transformed"] = macrosToNames(CategoriesNotTransformed);
+        Shard["transformed decl names"] = names(TransformedDeclNames);
+        Shard["transformed macros"] = macros(TransformedMacros);
+        Shard["transformed definitions to visit"] = nlohmann::json::array();
+        for (auto &&it : TransformedDefToVisit)
+        {
+            Shard["transformed definitions to visit"].push_back({Macros.get(it.first), Names.get(it.second)});
+        }
+        Shard["transformed invocations"] = nlohmann::json::array();
+        for (auto &&it : TransformedInvocations)
+        {
+            for (auto &&Count : it.second)
+            {
+                Shard["transformed invocations"].push_back(
+                    {Files.get(it.first.first), Names.get(it.first.second), Macros.get(Count.first), Count.second});
+            }
+        }
+        Shard["transformed types"] = macrosToNames(TransformedTypes);
+        Shard["macros transformed to vars"] = macros(MacrosTransformedToVars);
+        return Shard;
+    }
+
+    unsigned EventSummary::getCrashes() const
+    {
+        return Crashes;
+    }
+
+    // Formats a number of seconds the way run_evaluation.py formats a
+    // timedelta
+    static std::string formatSeconds(double Seconds)
+    {
+        auto Microseconds = (long long)std::llround(Seconds * 1e6);
+        return std::to_string((Microseconds / 1000000) % 86400) + "s " +
+               std::to_string(Microseconds % 1000000) + "us";
+    }
+
+    // Formats a float the way Python's str does: with the fewest
+    // significant digits that read back as the same float, in fixed
+    // notation unless its exponent is below -4 or above 15
+    static std::string formatFloat(double D)
+    {
+        char Buffer[32];
+        int Precision = 1;
+        for (; Precision < 17; Precision++)
+        {
+            std::snprintf(Buffer, sizeof(Buffer), "%.*e", Precision - 1, D);
+            if (std::strtod(Buffer, nullptr) == D)
+            {
+                break;
+            }
+        }
+        std::snprintf(Buffer, sizeof(Buffer), "%.*e", Precision - 1, D);
+
+        std::string S = Buffer;
+        std::string Sign = "";
+        if (S[0] == '-')
+        {
+            Sign = "-";
+            S = S.substr(1);
+        }
+        auto E = S.find('e');
+        int Exponent = std::stoi(S.substr(E + 1));
+        std::string Digits = S.substr(0, E);
+        Digits.erase(std::remove(Digits.begin(), Digits.end(), '.'), Digits.end());
+
+        // The number of digits before the decimal point
+        int Point = Exponent + 1;
+        if (-4 < Point && Point <= 16)
+        {
+            if (Point <= 0)
+            {
+                return Sign + "0." + std::string(-Point, '0') + Digits;
+            }
+            if (Point >= (int)Digits.size())
+            {
+                return Sign + Digits + std::string(Point - Digits.size(), '0') + ".0";
+            }
+            return Sign + Digits.substr(0, Point) + "." + Digits.substr(Point);
+        }
+
+        std::string Mantissa = Digits.substr(0, 1);
+        if (Digits.size() > 1)
+        {
+            Mantissa += "." + Digits.substr(1);
+        }
+        std::snprintf(Buffer, sizeof(Buffer), "e%c%02d", Exponent < 0 ? '-' : '+', std::abs(Exponent));
+        return Sign + Mantissa + Buffer;
+    }
+
+    // Formats a list of (macro name, value) pairs the way Python prints
+    // a list of tuples
+    static std::string formatTopFive(
+        const StringPool &Macros,
+        std::vector<std::pair<unsigned, std::size_t>> MacroValues)
+    {
+        std::stable_sort(MacroValues.begin(), MacroValues.end(),
+                         [](const std::pair<unsigned, std::size_t> &A,
+                            const std::pair<unsigned, std::size_t> &B)
+                         { return A.second > B.second; });
+        std::string S = "[";
+        for (std::size_t i = 0; i < MacroValues.size() && i < 5; i++)
+        {
+            if (i > 0)
+            {
+                S += ", ";
+            }
+            // The macro name is the first part of its hash
+            S += "('" + split(Macros.get(MacroValues[i].first), ';')[0] + "', " +
+                 std::to_string(MacroValues[i].second) + ")";
+        }
+        return S + "]";
+    }
+
+    // Returns the 0th, 5th, ..., 100th percentiles of the given data, like
+    // twenty_num in summaries.py
+    static std::vector<double> twentyNum(std::vector<std::size_t> Data)
+    {
+        // To avoid errors when passing an empty array
+        if (Data.empty())
+        {
+            Data.push_back(0);
+        }
+        std::sort(Data.begin(), Data.end());
+        std::vector<double> Percentiles;
+        for (unsigned P = 0; P <= 100; P += 5)
+        {
+            // numpy's midpoint method
+            double Index = P / 100.0 * (Data.size() - 1);
+            auto Lower = Data[(std::size_t)std::floor(Index)];
+            auto Upper = Data[(std::size_t)std::ceil(Index)];
+            Percentiles.push_back((Lower + Upper) / 2.0);
+        }
+        return Percentiles;
+    }
+
+    void EventSummary::print(std::ostream &OS) const
+    {
+        auto isOLM = [&](unsigned MHash)
+        { return Macros.get(MHash).find(OLM_TAG) != std::string::npos; };
+        auto isFLM = [&](unsigned MHash)
+        { return Macros.get(MHash).find(FLM_TAG) != std::string::npos; };
+
+        // Prints the number of macros in the given set, and how many are
+        // object-like and function-like
+        auto macroSetStat = [&](const std::string &Stat, const std::set<unsigned> &S)
+        {
+            OS << Stat << ": " << S.size() << '\n'
+               << "    olms: " << std::count_if(S.begin(), S.end(), isOLM) << '\n'
+               << "    flms: " << std::count_if(S.begin(), S.end(), isFLM) << '\n';
+        };
+        auto keys = [](const auto &M)
+        {
+            std::set<unsigned> Keys;
+            for (auto &&it : M)
+            {
+                Keys.insert(it.first);
+            }
+            return Keys;
+        };
+        // Prints the sum of the given per-macro values, and the sums for
+        // object-like and function-like macros
+        auto macroSumStat = [&](const std::string &Stat, const std::map<unsigned, std::size_t> &M)
+        {
+            std::size_t Total = 0, OLMs = 0, FLMs = 0;
+            for (auto &&it : M)
+            {
+                Total += it.second;
+                OLMs += isOLM(it.first) ? it.second : 0;
+                FLMs += isFLM(it.first) ? it.second : 0;
+            }
+            OS << Stat << ": " << Total << '\n'
+               << "    olms: " << OLMs << '\n'
+               << "    flms: " << FLMs << '\n';
+        };
+
+        // Macro counts
+
+        std::map<unsigned, std::size_t> ExpansionCounts;
+        for (auto &&it : RawExpansionSpellingLocations)
+        {
+            ExpansionCounts[it.first] = it.second.size();
+        }
+        macroSetStat("source macro definitions", SourceMacroDefinitions);
+        macroSetStat("expanded source macro definitions", keys(RawExpansionSpellingLocations));
+        std::size_t UniqueRawSourceMacroExpansions = 0;
+        for (auto &&it : ExpansionCounts)
+        {
+            UniqueRawSourceMacroExpansions += it.second;
+        }
+        OS << "unique source macro expansions: " << UniqueRawSourceMacroExpansions << '\n';
+
+        // Transformation
+
+        OS << "runs to reach a fixed point: " << RunsToFixedPoint << '\n';
+        for (auto Max : {true, false})
+        {
+            OS << (Max ? "max" : "sum") << " time needed to transform each file\n[";
+            bool First = true;
+            for (auto &&it : FileTransformSeconds)
+            {
+                OS << (First ? "" : ", ") << "["
+                   << nlohmann::json(Files.get(it.first)).dump() << ", "
+                   << nlohmann::json(formatSeconds(Max ? it.second.first : it.second.second)).dump() << "]";
+                First = false;
+            }
+            OS << "]\n";
+        }
+
+        auto PotentiallyTransformableMacros = keys(PotentiallyTransformableMacroRawSigs);
+        macroSetStat("potentially transformable macro definitions", PotentiallyTransformableMacros);
+        macroSetStat("transformed macro definitions", TransformedMacros);
+
+        // Only consider potentially transformable macros which were
+        // never transformed
+        std::map<unsigned, std::set<unsigned>> PTCategoriesNotTransformed;
+        for (auto &&it : CategoriesNotTransformed)
+        {
+            if (PotentiallyTransformableMacros.count(it.first) &&
+                !TransformedMacros.count(it.first))
+            {
+                PTCategoriesNotTransformed.insert(it);
+            }
+        }
+        macroSetStat("untransformed potentially transformable macro definitions", keys(PTCategoriesNotTransformed));
+
+        OS << "number of macros transformed to vars: " << MacrosTransformedToVars.size() << '\n';
+        OS << "percentage increase in transformed macros with our approach: ";
+        if (MacrosTransformedToVars.empty())
+        {
+            OS << "N/A\n";
+        }
+        else
+        {
+            double Increase = ((double)TransformedMacros.size() - MacrosTransformedToVars.size()) /
+                              MacrosTransformedToVars.size() * 100;
+            OS << formatFloat(Increase) << "%\n";
+        }
+
+        // For each category, count the macros that were only not
+        // transformed for that category, and count macros that were not
+        // transformed for multiple categories
+        for (auto FLMsOnly : {false, true})
+        {
+            OS << "categories of reasons not transformed" << (FLMsOnly ? " (flms)" : "") << ":\n";
+            std::size_t MultipleCategories = 0;
+            std::map<std::string, std::size_t> CategoryCounts;
+            for (auto &&it : PTCategoriesNotTransformed)
+            {
+                if (FLMsOnly && !isFLM(it.first))
+                {
+                    continue;
+                }
+                if (it.second.size() == 1)
+                {
+                    CategoryCounts[Names.get(*it.second.begin())] += 1;
+                }
+                else if (it.second.size() > 1)
+                {
+                    MultipleCategories += 1;
+                }
+            }
+            for (auto &&Category : CATEGORIES_NOT_TRANSFORMED)
+            {
+                std::string Lower = Category;
+                std::transform(Lower.begin(), Lower.end(), Lower.begin(), ::tolower);
+                OS << "    " << Lower << ": " << CategoryCounts[Category] << '\n';
+            }
+            OS << "    multiple categories: " << MultipleCategories << '\n';
+        }
+
+        // Only consider expansions of macros Cpp2C said
+        // it could potentially transform
+        std::map<unsigned, std::size_t> PotentiallyTransformableExpansions;
+        std::size_t PotentiallyTransformableInvocations = 0;
+        for (auto &&it : ExpansionCounts)
+        {
+            if (PotentiallyTransformableMacros.count(it.first))
+            {
+                PotentiallyTransformableExpansions.insert(it);
+                PotentiallyTransformableInvocations += it.second;
+            }
+        }
+        macroSumStat("potentially transformable invocations", PotentiallyTransformableExpansions);
+
+        // Count the number of transformed invocations in source definitions
+        std::map<unsigned, std::size_t> UniqueTransformedInvocations;
+        std::size_t UniqueSourceTransformedInvocations = 0;
+        for (auto &&it : TransformedInvocations)
+        {
+            if (!TransformedDeclNames.count(it.first.second))
+            {
+                for (auto &&Count : it.second)
+                {
+                    UniqueSourceTransformedInvocations += Count.second;
+                    UniqueTransformedInvocations[Count.first] += Count.second;
+                }
+            }
+        }
+        OS << "unique transformed invocations in source definitions: " << UniqueSourceTransformedInvocations << '\n';
+
+        // Count the number of transformed invocations in transformed
+        // definitions. We only consider one file's definition of each
+        // canonical def
+        std::set<unsigned> CanonicalDefs;
+        for (auto &&it : TransformedDefToVisit)
+        {
+            CanonicalDefs.insert(it.second);
+        }
+        std::set<unsigned> CanonicalDefsAlreadyFoundADefFor;
+        std::size_t UniqueTransformedDefTransformedInvocations = 0;
+        for (auto &&it : TransformedInvocations)
+        {
+            auto Decl = it.first.second;
+            if (TransformedDeclNames.count(Decl) && CanonicalDefs.count(Decl) &&
+                CanonicalDefsAlreadyFoundADefFor.insert(Decl).second)
+            {
+                for (auto &&Count : it.second)
+                {
+                    UniqueTransformedDefTransformedInvocations += Count.second;
+                    UniqueTransformedInvocations[Count.first] += Count.second;
+                }
+            }
+        }
+        OS << "unique transformed invocations in transformed definitions: "
+           << UniqueTransformedDefTransformedInvocations << '\n';
+        macroSumStat("total unique transformed invocations", UniqueTransformedInvocations);
+
+        // Which macros had the most transformed invocations?
+        OS << "top five most transformed macros: "
+           << formatTopFive(Macros, {UniqueTransformedInvocations.begin(), UniqueTransformedInvocations.end()})
+           << '\n';
+
+        OS << "untransformed invocations: "
+           << (long long)PotentiallyTransformableInvocations -
+                  (long long)(UniqueSourceTransformedInvocations + UniqueTransformedDefTransformedInvocations)
+           << '\n';
+
+        std::set<unsigned> PotentiallyTransformablePolyMacros;
+        for (auto &&it : PotentiallyTransformableMacroRawSigs)
+        {
+            if (it.second.size() > 1)
+            {
+                PotentiallyTransformablePolyMacros.insert(it.first);
+            }
+        }
+        macroSetStat("potentially transformable polymorphic macros", PotentiallyTransformablePolyMacros);
+
+        std::set<unsigned> TransformedPolyMacros;
+        std::vector<std::size_t> TransformedTypeCounts;
+        std::vector<std::pair<unsigned, std::size_t>> MacroTransformedTypeCounts;
+        for (auto &&it : TransformedTypes)
+        {
+            if (it.second.size() > 1)
+            {
+                TransformedPolyMacros.insert(it.first);
+            }
+            TransformedTypeCounts.push_back(it.second.size());
+            MacroTransformedTypeCounts.push_back({it.first, it.second.size()});
+        }
+        macroSetStat("transformed polymorphic macros", TransformedPolyMacros);
+
+        OS << "twenty pt summary of transformed types: [";
+        bool First = true;
+        for (auto P : twentyNum(TransformedTypeCounts))
+        {
+            OS << (First ? "" : " ") << P;
+            First = false;
+        }
+        OS << "]\n";
+
+        // For fun: Which macros had the most uniquely typed transformations?
+        OS << "macros with most transformed types: "
+           << formatTopFive(Macros, MacroTransformedTypeCounts) << '\n';
+    }
+} // namespace Summarizer
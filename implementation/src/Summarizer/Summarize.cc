@@ -0,0 +1,102 @@
+// Computes the summary of an evaluated program from the event records
+// written while evaluating it, or from shards of summaries computed by
+// parallel workers
+
+#include "Summarizer/EventSummary.hh"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const std::string USAGE_STRING = "USAGE: cpp2c-summarize [--shard=OUT] (EVENTS_FILE|SHARD.json)+";
+
+static bool endsWith(const std::string &S, const std::string &Suffix)
+{
+    return S.size() >= Suffix.size() &&
+           S.compare(S.size() - Suffix.size(), Suffix.size(), Suffix) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string ShardPath;
+    std::vector<std::string> Inputs;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string Arg = argv[i];
+        if (Arg.rfind("--shard=", 0) == 0)
+        {
+            ShardPath = Arg.substr(std::string("--shard=").size());
+        }
+        else if (Arg == "-h" || Arg == "--help")
+        {
+            std::cout << USAGE_STRING << std::endl;
+            return 0;
+        }
+        else
+        {
+            Inputs.push_back(Arg);
+        }
+    }
+    if (Inputs.empty())
+    {
+        std::cerr << USAGE_STRING << std::endl;
+        return 1;
+    }
+
+    // Inputs are merged in the order they are given, since the first
+    // definition a transformed macro's expansions refer to is the one
+    // counted
+    Summarizer::EventSummary Summary;
+    for (auto &&Input : Inputs)
+    {
+        std::ifstream IS(Input);
+        if (!IS.good())
+        {
+            std::cerr << "Error: could not open " << Input << std::endl;
+            return 1;
+        }
+
+        std::string Err;
+        bool Ok;
+        if (endsWith(Input, ".json"))
+        {
+            nlohmann::json Shard = nlohmann::json::parse(IS, nullptr, false);
+            Ok = !Shard.is_discarded() && Summary.addShard(Shard, Err);
+        }
+        else
+        {
+            Ok = Summary.addRecords(IS, Err);
+        }
+        if (!Ok)
+        {
+            std::cerr << "Error: malformed input " << Input
+                      << (Err.empty() ? "" : ": " + Err) << std::endl;
+            return 1;
+        }
+    }
+
+    if (!ShardPath.empty())
+    {
+        std::ofstream OS(ShardPath);
+        if (!OS.good())
+        {
+            std::cerr << "Error: could not write " << ShardPath << std::endl;
+            return 1;
+        }
+        OS << Summary.toShard().dump();
+        return 0;
+    }
+
+    Summary.print(std::cout);
+
+    // The statistics leave out the translation units Clang crashed on,
+    // so they are incomplete
+    if (Summary.getCrashes() != 0)
+    {
+        std::cerr << "Error: Clang crashed on " << Summary.getCrashes()
+                  << " translation units" << std::endl;
+        return 1;
+    }
+    return 0;
+}
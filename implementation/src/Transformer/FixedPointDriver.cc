@@ -0,0 +1,206 @@
+#include "Transformer/FixedPointDriver.hh"
+#include "Transformer/TransformerConsumer.hh"
+
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendAction.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+namespace Transformer
+{
+    namespace
+    {
+        // Runs the transformer on a translation unit and records its
+        // result instead of writing any files
+        class TransformerAction : public clang::ASTFrontendAction
+        {
+        private:
+            TransformerSettings TSettings;
+            std::shared_ptr<Utils::UniqueNameGenerator> Names;
+            std::shared_ptr<SignatureVerdictCache> VerdictCache;
+            std::shared_ptr<Utils::AnnotationManifest> Manifest;
+            TransformationResult &Result;
+
+        public:
+            TransformerAction(
+                TransformerSettings TSettings,
+                std::shared_ptr<Utils::UniqueNameGenerator> Names,
+                std::shared_ptr<SignatureVerdictCache> VerdictCache,
+                std::shared_ptr<Utils::AnnotationManifest> Manifest,
+                TransformationResult &Result)
+                : TSettings(TSettings), Names(Names),
+                  VerdictCache(VerdictCache), Manifest(Manifest),
+                  Result(Result) {}
+
+        protected:
+            std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(
+                clang::CompilerInstance &CI,
+                llvm::StringRef file) override
+            {
+                return std::make_unique<TransformerConsumer>(
+                    &CI, TSettings, Names, &Result, VerdictCache, Manifest);
+            }
+        };
+    } // namespace
+
+    bool FixedPointDriver::Running = false;
+
+    FixedPointDriver::FixedPointDriver(
+        clang::CompilerInstance &CI,
+        TransformerSettings TSettings,
+        std::shared_ptr<Utils::UniqueNameGenerator> Names,
+        std::shared_ptr<SignatureVerdictCache> VerdictCache,
+        std::shared_ptr<Utils::AnnotationManifest> Manifest,
+        std::chrono::steady_clock::time_point TUDeadline)
+        : CI(CI), TSettings(TSettings), Names(Names),
+          VerdictCache(VerdictCache), Manifest(Manifest),
+          TUDeadline(TUDeadline) {}
+
+    bool FixedPointDriver::isRunning() { return Running; }
+
+    bool FixedPointDriver::run(const TransformationResult &FirstResult)
+    {
+        TransformationResult Result = FirstResult;
+        unsigned Iterations = 1;
+        while (true)
+        {
+            if (Result.BudgetExceeded)
+            {
+                break;
+            }
+
+            // Keep the last iteration's edits too, since it may have
+            // updated annotations without transforming anything
+            for (auto &&it : Result.RewrittenFiles)
+            {
+                Buffers[it.first] = it.second;
+            }
+            if (Result.TransformedExpansions == 0)
+            {
+                break;
+            }
+
+            // Give up if there is no time left for another iteration
+            if (std::chrono::steady_clock::now() >= TUDeadline)
+            {
+                Result.BudgetExceeded = true;
+                break;
+            }
+
+            Result = TransformationResult();
+            if (runIteration(Result))
+            {
+                return true;
+            }
+            Iterations += 1;
+        }
+
+        BudgetExceeded = Result.BudgetExceeded;
+        if (TSettings.Verbose)
+        {
+            if (BudgetExceeded)
+            {
+                llvm::errs() << "Time budget exceeded after " << Iterations
+                             << " iterations\n";
+            }
+            else
+            {
+                llvm::errs() << "Reached a fixed point after " << Iterations
+                             << " iterations\n";
+            }
+        }
+
+        return false;
+    }
+
+    bool FixedPointDriver::budgetExceeded() const { return BudgetExceeded; }
+
+    const std::string *FixedPointDriver::getRewrittenFile(const std::string &Path) const
+    {
+        auto it = Buffers.find(Path);
+        return it == Buffers.end() ? nullptr : &it->second;
+    }
+
+    bool FixedPointDriver::runIteration(TransformationResult &Result)
+    {
+        // Overlay the rewritten files on the real file system.
+        // An in-memory file's contents can't be replaced, so a new
+        // file system is created for each iteration
+        auto InMemoryFS = llvm::makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+        auto RealFS = llvm::vfs::getRealFileSystem();
+        if (auto CWD = RealFS->getCurrentWorkingDirectory())
+        {
+            InMemoryFS->setCurrentWorkingDirectory(*CWD);
+        }
+        for (auto &&it : Buffers)
+        {
+            InMemoryFS->addFile(it.first, 0,
+                                llvm::MemoryBuffer::getMemBufferCopy(it.second, it.first));
+        }
+        auto OverlayFS = llvm::makeIntrusiveRefCnt<llvm::vfs::OverlayFileSystem>(RealFS);
+        OverlayFS->pushOverlay(InMemoryFS);
+
+        // Parse the translation unit again with the same options,
+        // but without any plugins
+        auto Invocation = std::make_shared<clang::CompilerInvocation>(CI.getInvocation());
+        Invocation->getFrontendOpts().AddPluginActions.clear();
+        Invocation->getFrontendOpts().PluginArgs.clear();
+
+        clang::CompilerInstance IterationCI(CI.getPCHContainerOperations());
+        IterationCI.setInvocation(Invocation);
+        IterationCI.createDiagnostics();
+        IterationCI.createFileManager(OverlayFS);
+
+        // The iteration gets the time that is left of the budget
+        TransformerSettings IterationSettings = TSettings;
+        if (TSettings.HasTUBudget)
+        {
+            auto Left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                TUDeadline - std::chrono::steady_clock::now());
+            IterationSettings.TUBudgetMs = std::max<long long>(Left.count(), 0);
+        }
+
+        TransformerAction Action(IterationSettings, Names, VerdictCache, Manifest, Result);
+        Running = true;
+        bool Succeeded = IterationCI.ExecuteAction(Action);
+        Running = false;
+        return !Succeeded;
+    }
+
+    bool FixedPointDriver::flush()
+    {
+        std::map<std::string, std::string> TempPaths;
+        for (auto &&it : Buffers)
+        {
+            std::string TempPath = it.first + ".cpp2c-tmp";
+            std::error_code EC;
+            llvm::raw_fd_ostream OS(TempPath, EC, llvm::sys::fs::OF_None);
+            if (EC)
+            {
+                llvm::errs() << "Error: Could not write " << TempPath << "\n";
+                for (auto &&Written : TempPaths)
+                {
+                    llvm::sys::fs::remove(Written.second);
+                }
+                return true;
+            }
+            OS << it.second;
+            TempPaths[it.first] = TempPath;
+        }
+
+        bool Failed = false;
+        for (auto &&it : TempPaths)
+        {
+            if (llvm::sys::fs::rename(it.second, it.first))
+            {
+                llvm::errs() << "Error: Could not write " << it.first << "\n";
+                Failed = true;
+            }
+        }
+        return Failed;
+    }
+} // namespace Transformer
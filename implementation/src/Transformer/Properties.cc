@@ -6,8 +6,10 @@
 #include <vector>
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 
 namespace Transformer
 {
@@ -21,20 +23,70 @@ namespace Transformer
     using llvm::isa_and_nonnull;
     using namespace Utils;
 
+    std::string OUT_OF_TIME = "Ran out of time";
+
+    // Returns true if a check has run past its deadline
+    static bool pastDeadline(std::chrono::steady_clock::time_point Deadline)
+    {
+        return Deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= Deadline;
+    }
+
     std::string isWellFormed(
         CppSig::MacroExpansionNode *Expansion,
         clang::ASTContext &Ctx,
         clang::Preprocessor &PP)
     {
-        clang::SourceManager &SM = Ctx.getSourceManager();
+        std::string errMsg = isInConstExprContext(Expansion, Ctx);
+        if (errMsg != "")
+        {
+            return errMsg;
+        }
+
+        errMsg = isWellFormedStructure(Expansion, Ctx);
+        if (errMsg != "")
+        {
+            return errMsg;
+        }
+
+        return isWellFormedSpelling(Expansion, Ctx, PP);
+    }
+
+    std::string isInConstExprContext(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx,
+        bool AllowEnumConstants)
+    {
+        // The structural check reports expansions without statements
+        if (Expansion->getStmtsRef().empty())
+        {
+            return "";
+        }
 
         // Don't transform expansions appearing where a const expr
         // is required
         if (mustBeConstExpr(Ctx, *Expansion->getStmtsRef().begin()))
         {
+            // Enum constants are constant expressions themselves.
+            // This check may run before the structural one, so check
+            // the structure here too
+            if (AllowEnumConstants &&
+                Expansion->getStmtsRef().size() == 1 &&
+                isa_and_nonnull<Expr>(*Expansion->getStmtsRef().begin()) &&
+                transformsToEnumConstant(Expansion, Ctx))
+            {
+                return "";
+            }
             return "Const expr required";
         }
 
+        return "";
+    }
+
+    std::string isWellFormedStructure(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx)
+    {
         // Check that the expansion maps to a single expansion
         if (Expansion->getSubtreeNodesRef().size() < 1)
         {
@@ -62,6 +114,21 @@ namespace Transformer
             return "Did not expand to an expression";
         }
 
+        return "";
+    }
+
+    std::string isWellFormedSpelling(
+        CppSig::MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx,
+        clang::Preprocessor &PP,
+        std::chrono::steady_clock::time_point Deadline)
+    {
+        clang::SourceManager &SM = Ctx.getSourceManager();
+
+        auto ST = *Expansion->getStmtsRef().begin();
+        auto E = dyn_cast_or_null<Expr>(ST);
+        assert(E != nullptr);
+
         // Check that expression is completely covered by the expansion
         {
             auto ExpansionBegin = Expansion->getSpellingRange().getBegin();
@@ -99,6 +166,11 @@ namespace Transformer
                 auto ArgFirstExpansion = *Arg.getStmtsRef().begin();
                 for (auto ArgExpansion : Arg.getStmtsRef())
                 {
+                    if (pastDeadline(Deadline))
+                    {
+                        return OUT_OF_TIME;
+                    }
+
                     // TODO: Check this condition?
                     if (!compareTrees(Ctx, ArgFirstExpansion, ArgExpansion) && false)
                     {
@@ -130,7 +202,8 @@ namespace Transformer
 
     std::string isEnvironmentCapturing(
         CppSig::MacroExpansionNode *Expansion,
-        clang::ASTContext &Ctx)
+        clang::ASTContext &Ctx,
+        std::chrono::steady_clock::time_point Deadline)
     {
         auto ST = *Expansion->getStmtsRef().begin();
         auto E = dyn_cast_or_null<Expr>(ST);
@@ -140,27 +213,26 @@ namespace Transformer
         {
             std::vector<const DeclRefExpr *> DREs;
             collectLocalVarDeclRefExprs(E, &DREs);
-            for (auto &&DRE : DREs)
+
+            // Walk each argument's statements once to collect all the
+            // nodes the arguments own, so that checking whether a
+            // variable comes from an argument is a single lookup
+            std::unordered_set<const Stmt *> StmtsFromArgs;
+            for (auto &&Arg : Expansion->getArgumentsRef())
             {
-                bool varComesFromArg = false;
-                // Check all the macros arguments for the variable
-                for (auto &&Arg : Expansion->getArgumentsRef())
+                for (auto &&S : Arg.getStmtsRef())
                 {
-                    for (auto &&S : Arg.getStmtsRef())
-                    {
-                        if (containsDeclRefExpr(S, DRE))
-                        {
-                            varComesFromArg = true;
-                            break;
-                        }
-                    }
-                    if (varComesFromArg)
-                    {
-                        break;
-                    }
+                    collectSubStmts(S, StmtsFromArgs);
                 }
+                if (pastDeadline(Deadline))
+                {
+                    return OUT_OF_TIME;
+                }
+            }
 
-                if (!varComesFromArg)
+            for (auto &&DRE : DREs)
+            {
+                if (StmtsFromArgs.find(DRE) == StmtsFromArgs.end())
                 {
                     return "Captures environment";
                 }
@@ -172,7 +244,8 @@ namespace Transformer
 
     std::string isParamSEFreeAndLValueIndependent(
         CppSig::MacroExpansionNode *Expansion,
-        clang::ASTContext &Ctx)
+        clang::ASTContext &Ctx,
+        std::chrono::steady_clock::time_point Deadline)
     {
         // Don't transform expansions which:
         // 1)   Change the R-value associated with the L-value of a symbol
@@ -196,25 +269,36 @@ namespace Transformer
         for (auto &&it : Expansion->getArgumentsRef())
         {
             collectLValuesSpelledInRange(Ctx, ST, it.getTokenRangesRef(), &LValuesFromArgs);
+            if (pastDeadline(Deadline))
+            {
+                return OUT_OF_TIME;
+            }
         }
+        // Hash the L-values so that each subtree below only needs to be
+        // walked once to check whether it contains any of them
+        std::unordered_set<const Stmt *> LValuesFromArgsSet(
+            LValuesFromArgs.begin(), LValuesFromArgs.end());
 
         std::set<const Stmt *> StmtsThatChangeRValue;
         collectStmtsThatChangeRValue(ST, &StmtsThatChangeRValue);
-        for (auto &&StmtThatChangesRValue : StmtsThatChangeRValue)
+        if (!LValuesFromArgsSet.empty())
         {
-            for (auto &&LVal : LValuesFromArgs)
+            for (auto &&StmtThatChangesRValue : StmtsThatChangeRValue)
             {
+                if (pastDeadline(Deadline))
+                {
+                    return OUT_OF_TIME;
+                }
                 if (auto UO = dyn_cast_or_null<clang::UnaryOperator>(StmtThatChangesRValue))
                 {
-
-                    if (containsStmt(UO, LVal))
+                    if (containsAnyStmt(UO, LValuesFromArgsSet))
                     {
                         return "Writes to R-value of symbol from arguments in unary expression";
                     }
                 }
                 else if (auto BO = dyn_cast_or_null<BinaryOperator>(StmtThatChangesRValue))
                 {
-                    if (containsStmt(BO->getLHS(), LVal))
+                    if (containsAnyStmt(BO->getLHS(), LValuesFromArgsSet))
                     {
                         return "Writes to R-value of symbol from arguments in a binary expression";
                     }
@@ -231,6 +315,11 @@ namespace Transformer
         collectStmtsThatReturnLValue(ST, &StmtsThatReturnLValue);
         for (auto &&StmtThatReturnsLValue : StmtsThatReturnLValue)
         {
+            if (pastDeadline(Deadline))
+            {
+                return OUT_OF_TIME;
+            }
+
             bool isOk = false;
             // We can allow this statement if the entire expression
             // came from a single argument
@@ -249,12 +338,9 @@ namespace Transformer
                 break;
             }
 
-            for (auto &&LVal : LValuesFromArgs)
+            if (containsAnyStmt(StmtThatReturnsLValue, LValuesFromArgsSet))
             {
-                if (containsStmt(StmtThatReturnsLValue, LVal))
-                {
-                    return "Contains an expression that returns L-value of symbol from arguments";
-                }
+                return "Contains an expression that returns L-value of symbol from arguments";
             }
         }
 
@@ -272,6 +358,10 @@ namespace Transformer
             // Check that function call is not on LHS of assignment
             while (Parents.size() > 0)
             {
+                if (pastDeadline(Deadline))
+                {
+                    return OUT_OF_TIME;
+                }
                 auto P = Parents[0];
                 if (auto BO = P.get<clang::BinaryOperator>())
                 {
@@ -290,6 +380,10 @@ namespace Transformer
             Parents = Ctx.getParents(*E);
             while (Parents.size() > 0)
             {
+                if (pastDeadline(Deadline))
+                {
+                    return OUT_OF_TIME;
+                }
                 auto P = Parents[0];
                 if (auto UO = P.get<clang::UnaryOperator>())
                 {
@@ -306,6 +400,10 @@ namespace Transformer
             Parents = Ctx.getParents(*E);
             while (Parents.size() > 0)
             {
+                if (pastDeadline(Deadline))
+                {
+                    return OUT_OF_TIME;
+                }
                 auto P = Parents[0];
                 if (auto UO = P.get<clang::UnaryOperator>())
                 {
@@ -321,11 +419,8 @@ namespace Transformer
         return "";
     }
 
-    std::string isUnsupportedConstruct(
-        Transformer::TransformedDefinition *TD,
-        clang::ASTContext &Ctx,
-        Rewriter &RW,
-        std::set<std::string> AllowedMacroDefFileRealPaths)
+    std::string isUnsupportedSignature(
+        Transformer::TransformedDefinition *TD)
     {
         // Don't transform definitions with signatures with array types
         // TODO:    Check if the type *contains* an array type, not just
@@ -428,6 +523,16 @@ namespace Transformer
             }
         }
 
+        return "";
+    }
+
+    std::string isUnsupportedConstruct(
+        Transformer::TransformedDefinition *TD,
+        clang::ASTContext &Ctx,
+        const std::set<std::string> &AllowedMacroDefFileRealPaths)
+    {
+        auto ST = *TD->getExpansion()->getStmtsRef().begin();
+
         // Check that expansion is inside a function, because if it
         // isn't none of the constructs we transform to
         // (var and function call) would be valid at the global scope
@@ -439,7 +544,7 @@ namespace Transformer
         // Check that the transformed declaration location is allowed
         {
             auto TransformedDeclarationLoc = TD->getTransformedDeclarationLocation(Ctx);
-            if (!RW.isRewritable(TransformedDeclarationLoc))
+            if (!Rewriter::isRewritable(TransformedDeclarationLoc))
             {
                 return "Transformed declaration not in a rewritable location";
             }
@@ -469,7 +574,7 @@ namespace Transformer
         // Check that the transformed definition location is allowed
         {
             auto TransformedDefinitionLoc = TD->getTransformedDefinitionLocation(Ctx);
-            if (!RW.isRewritable(TransformedDefinitionLoc))
+            if (!Rewriter::isRewritable(TransformedDefinitionLoc))
             {
                 return "Transformed definition not in a rewritable location";
             }
@@ -481,8 +586,8 @@ namespace Transformer
 
         // Check that transformed expansion range is allowed
         {
-            if (!RW.isRewritable(TD->getInvocationReplacementRange().getBegin()) ||
-                !RW.isRewritable(TD->getInvocationReplacementRange().getEnd()))
+            if (!Rewriter::isRewritable(TD->getInvocationReplacementRange().getBegin()) ||
+                !Rewriter::isRewritable(TD->getInvocationReplacementRange().getEnd()))
             {
                 return "Expansion not in a rewritable location";
             }
@@ -0,0 +1,307 @@
+#include "Transformer/PropertyPipeline.hh"
+#include "Transformer/Properties.hh"
+#include "Utils/ExpansionUtils.hh"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Transformer
+{
+    using CppSig::MacroExpansionNode;
+    using std::string;
+
+    string SYNTAX = "Syntactic well-formedness",
+           ENVIRONMENT_CAPTURE = "Environment capture",
+           PARAMETER_SIDE_EFFECTS = "Parameter side-effects",
+           UNSUPPORTED_CONSTRUCT = "Unsupported construct",
+           TURNED_OFF_CONSTRUCT = "Turned off construct",
+           TIME_BUDGET_EXCEEDED = "Time budget exceeded";
+
+    PropertyCheckContext::PropertyCheckContext(
+        MacroExpansionNode *Expansion,
+        clang::ASTContext &Ctx,
+        clang::Preprocessor &PP,
+        const std::set<string> &AllowedMacroDefFileRealPaths,
+        SignatureVerdictCache &VerdictCache,
+        Utils::TypeStringCache &TypeStrings)
+        : Expansion(Expansion),
+          Ctx(Ctx),
+          PP(PP),
+          AllowedMacroDefFileRealPaths(AllowedMacroDefFileRealPaths),
+          VerdictCache(VerdictCache),
+          TypeStrings(TypeStrings) {}
+
+    TransformedDefinition *PropertyCheckContext::getTD()
+    {
+        if (!TD)
+        {
+            TD.reset(new TransformedDefinition(Ctx, Expansion, TypeStrings));
+        }
+        return TD.get();
+    }
+
+    bool PropertyVerdict::passed() const
+    {
+        return Category == "";
+    }
+
+    PropertyPipeline::PropertyPipeline(const TransformerSettings &TSettings)
+        : ExpansionBudgetMs(TSettings.ExpansionBudgetMs),
+          TUBudgetMs(TSettings.TUBudgetMs)
+    {
+        // The stages are listed in canonical order.
+        // This is the order the properties were originally checked in,
+        // and the evaluation relies on it for attributing rejections
+        // to categories.
+
+        // 1) Syntactic well-formedness.
+        // With enum constants, the const expr context check evaluates
+        // constant expressions, which fills caches in the ASTContext
+        // (e.g., record layouts for sizeof), so it can't run in parallel
+        bool AllowEnumConstants = TSettings.ConstantMode == CONSTANTS_ENUM;
+        Stages.push_back({"const expr context", SYNTAX, EXPENSIVE, !AllowEnumConstants,
+                          [AllowEnumConstants](PropertyCheckContext &PCC)
+                          {
+                              return isInConstExprContext(PCC.Expansion, PCC.Ctx,
+                                                          AllowEnumConstants);
+                          }});
+        Stages.push_back({"structure", SYNTAX, CHEAP, true,
+                          [](PropertyCheckContext &PCC)
+                          {
+                              return isWellFormedStructure(PCC.Expansion, PCC.Ctx);
+                          }});
+        Stages.push_back({"spelling", SYNTAX, MODERATE, false,
+                          [](PropertyCheckContext &PCC)
+                          {
+                              return isWellFormedSpelling(PCC.Expansion, PCC.Ctx, PCC.PP,
+                                                          PCC.StageDeadline);
+                          }});
+
+        // 2) No environment capture
+        Stages.push_back({"environment capture", ENVIRONMENT_CAPTURE, MODERATE, true,
+                          [](PropertyCheckContext &PCC)
+                          {
+                              return isEnvironmentCapturing(PCC.Expansion, PCC.Ctx,
+                                                            PCC.StageDeadline);
+                          }});
+
+        // 3) No side-effects in parameters and L-value independence
+        Stages.push_back({"parameter side-effects", PARAMETER_SIDE_EFFECTS, EXPENSIVE, false,
+                          [](PropertyCheckContext &PCC)
+                          {
+                              return isParamSEFreeAndLValueIndependent(PCC.Expansion, PCC.Ctx,
+                                                                       PCC.StageDeadline);
+                          }});
+
+        // 4) Not turned off.
+        // Currently the only construct that can be toggled is
+        // conditional evaluation (i.e., &&, ||, and ternary).
+        // This is turned off to prevent the accidental introduction
+        // of undefined behavior
+        if (!TSettings.TransformConditionalEvaluation)
+        {
+            Stages.push_back({"conditional evaluation", TURNED_OFF_CONSTRUCT, CHEAP, true,
+                              [](PropertyCheckContext &PCC)
+                              {
+                                  auto E = clang::dyn_cast_or_null<clang::Expr>(
+                                      *PCC.Expansion->getStmtsRef().begin());
+                                  if (Utils::containsConditionalEvaluation(E))
+                                  {
+                                      return string("Conditional evaluation turned off");
+                                  }
+                                  return string("");
+                              }});
+        }
+
+        // 5) Not unsupported.
+        // Checks which only depend on the definition and signature
+        // are looked up in the verdict cache first, since hot macros
+        // are expanded many times with the same signature
+        Stages.push_back({"unsupported signature", UNSUPPORTED_CONSTRUCT, CHEAP, true,
+                          [](PropertyCheckContext &PCC)
+                          {
+                              auto TD = PCC.getTD();
+                              string VerdictKey = SignatureVerdictCache::key(
+                                  PCC.Expansion->getMacroHash(),
+                                  PCC.Expansion->getDefinitionText(),
+                                  TD->getExpansionSignatureOrDeclaration(PCC.Ctx, false));
+                              string errMsg;
+                              if (!PCC.VerdictCache.lookup(VerdictKey, errMsg))
+                              {
+                                  errMsg = isUnsupportedSignature(TD);
+                                  PCC.VerdictCache.insert(VerdictKey, errMsg);
+                              }
+                              return errMsg;
+                          }});
+        Stages.push_back({"unsupported construct", UNSUPPORTED_CONSTRUCT, MODERATE, false,
+                          [](PropertyCheckContext &PCC)
+                          {
+                              return isUnsupportedConstruct(PCC.getTD(), PCC.Ctx,
+                                                            PCC.AllowedMacroDefFileRealPaths);
+                          }});
+
+        for (std::size_t i = 0; i < Stages.size(); i++)
+        {
+            CostOrder.push_back(i);
+        }
+        // Stable sort so that stages of the same cost keep their
+        // canonical order
+        std::stable_sort(CostOrder.begin(), CostOrder.end(),
+                         [this](std::size_t A, std::size_t B)
+                         {
+                             return Stages[A].Cost < Stages[B].Cost;
+                         });
+
+        // Every other stage assumes the structural check has passed
+        assert(Stages[CostOrder.front()].Name == "structure" &&
+               "Structural check must run first");
+    }
+
+    string PropertyPipeline::checkBudget(const PropertyCheckContext &PCC) const
+    {
+        if (ExpansionBudgetMs != 0 &&
+            PCC.AnalysisTime >= std::chrono::milliseconds(ExpansionBudgetMs))
+        {
+            return "Analysis took longer than the expansion budget of " +
+                   std::to_string(ExpansionBudgetMs) + "ms";
+        }
+        if (std::chrono::steady_clock::now() >= PCC.TUDeadline)
+        {
+            return "Translation unit took longer than its budget of " +
+                   std::to_string(TUBudgetMs) + "ms";
+        }
+        return "";
+    }
+
+    bool PropertyPipeline::rejectIfOverBudget(PropertyCheckContext &PCC) const
+    {
+        if (PCC.Verdict.Category == TIME_BUDGET_EXCEEDED)
+        {
+            return true;
+        }
+        string Reason = checkBudget(PCC);
+        if (Reason == "")
+        {
+            return false;
+        }
+        PCC.Rejected = true;
+        PCC.Verdict = {TIME_BUDGET_EXCEEDED, Reason};
+        return true;
+    }
+
+    PropertyVerdict PropertyPipeline::run(
+        PropertyCheckContext &PCC,
+        bool Attribute,
+        bool OnlyThreadSafe) const
+    {
+        if (PCC.RanStages.empty())
+        {
+            PCC.RanStages.assign(Stages.size(), false);
+        }
+
+        auto canRun = [&](std::size_t i)
+        {
+            return !PCC.RanStages[i] &&
+                   (!OnlyThreadSafe || Stages[i].ThreadSafe);
+        };
+
+        // Runs the given stage, timing it.
+        // The stage is stopped when either budget would run out
+        auto runStage = [&](std::size_t i)
+        {
+            auto Start = std::chrono::steady_clock::now();
+            PCC.StageDeadline = PCC.TUDeadline;
+            if (ExpansionBudgetMs != 0)
+            {
+                auto Left = std::chrono::milliseconds(ExpansionBudgetMs) - PCC.AnalysisTime;
+                PCC.StageDeadline = std::min(PCC.StageDeadline, Start + Left);
+            }
+            string Reason = Stages[i].Check(PCC);
+            PCC.AnalysisTime += std::chrono::steady_clock::now() - Start;
+            PCC.RanStages[i] = true;
+            return Reason;
+        };
+
+        // Rejects the expansion if it has run out of time.
+        // The rejection isn't attributed to a stage, since the stages
+        // that would decide which one to report may not have run.
+        // It is checked after each stage as well, since a stage that was
+        // stopped early returns a meaningless reason
+        bool BudgetExceeded = PCC.Verdict.Category == TIME_BUDGET_EXCEEDED;
+        auto exceedsBudget = [&]()
+        {
+            BudgetExceeded = rejectIfOverBudget(PCC);
+            return BudgetExceeded;
+        };
+
+        if (!PCC.Rejected)
+        {
+            for (auto i : CostOrder)
+            {
+                if (!canRun(i))
+                {
+                    continue;
+                }
+                if (exceedsBudget())
+                {
+                    break;
+                }
+                string Reason = runStage(i);
+                if (exceedsBudget())
+                {
+                    break;
+                }
+                if (Reason != "")
+                {
+                    PCC.Rejected = true;
+                    PCC.RejectingStage = i;
+                    PCC.Verdict = {Stages[i].Category, Reason};
+                    break;
+                }
+            }
+        }
+
+        if (PCC.Rejected && Attribute && !BudgetExceeded)
+        {
+            // Every stage which already ran passed, so the first stage
+            // in canonical order which fails is the one to report, and
+            // only the skipped stages before the rejecting one need to run.
+            // They are run cheapest first too: whenever one fails, it
+            // becomes the rejecting stage, and the stages after it no
+            // longer need to run
+            for (auto j : CostOrder)
+            {
+                if (j >= PCC.RejectingStage || PCC.RanStages[j])
+                {
+                    continue;
+                }
+                if (!canRun(j))
+                {
+                    // This stage is finished on the next call
+                    continue;
+                }
+                if (exceedsBudget())
+                {
+                    break;
+                }
+                string EarlierReason = runStage(j);
+                if (exceedsBudget())
+                {
+                    break;
+                }
+                if (EarlierReason != "")
+                {
+                    PCC.RejectingStage = j;
+                    PCC.Verdict = {Stages[j].Category, EarlierReason};
+                }
+            }
+        }
+
+        return PCC.Verdict;
+    }
+
+    const std::vector<PropertyCheckStage> &PropertyPipeline::getStagesRef() const
+    {
+        return Stages;
+    }
+} // namespace Transformer
@@ -0,0 +1,128 @@
+#include "Transformer/SignatureVerdictCache.hh"
+
+#include "nlohmann/single_include/json.hpp"
+
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace Transformer
+{
+    std::string SignatureVerdictCache::key(
+        const std::string &MacroHash,
+        const std::string &DefinitionText,
+        const std::string &Signature)
+    {
+        // Only a digest of the body is stored, since bodies may be long
+        llvm::MD5 Hash;
+        Hash.update(DefinitionText);
+        llvm::MD5::MD5Result Result;
+        Hash.final(Result);
+        return MacroHash + '\t' + Result.digest().str().str() + '\t' + Signature;
+    }
+
+    bool SignatureVerdictCache::lookup(
+        const std::string &Key,
+        std::string &Verdict) const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        auto it = Verdicts.find(Key);
+        if (it == Verdicts.end())
+        {
+            return false;
+        }
+        Verdict = it->second;
+        return true;
+    }
+
+    void SignatureVerdictCache::insert(
+        const std::string &Key,
+        const std::string &Verdict)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        auto Inserted = Verdicts.emplace(Key, Verdict);
+        Dirty = Dirty || Inserted.second;
+    }
+
+    // Adds the verdicts stored in the given file to Verdicts, keeping
+    // those already in it. Does nothing if the file does not exist or
+    // cannot be parsed
+    static void read(const std::string &Path,
+                     std::map<std::string, std::string> &Verdicts)
+    {
+        std::ifstream IS(Path);
+        if (!IS.good())
+        {
+            return;
+        }
+
+        // Don't throw on a malformed cache; just start with an empty one
+        nlohmann::json j = nlohmann::json::parse(IS, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+        {
+            return;
+        }
+
+        for (auto &&it : j.items())
+        {
+            if (it.value().is_string())
+            {
+                Verdicts.emplace(it.key(), it.value().get<std::string>());
+            }
+        }
+    }
+
+    void SignatureVerdictCache::load(const std::string &Path)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        read(Path, Verdicts);
+    }
+
+    void SignatureVerdictCache::save(const std::string &Path)
+    {
+        std::lock_guard<std::mutex> Guard(Mutex);
+        if (!Dirty)
+        {
+            return;
+        }
+
+        while (true)
+        {
+            llvm::LockFileManager Lock(Path);
+            if (Lock.getState() == llvm::LockFileManager::LFS_Shared)
+            {
+                // Another translation unit is writing the cache.
+                // If it takes too long, assume it died while holding
+                // the lock
+                if (Lock.waitForUnlock() == llvm::LockFileManager::Res_Timeout)
+                {
+                    Lock.unsafeRemoveLockFile();
+                }
+                continue;
+            }
+
+            // Keep the verdicts other translation units saved since this
+            // one loaded the cache. Verdicts only depend on their keys,
+            // so either copy of a verdict both have is as good
+            std::map<std::string, std::string> Merged = Verdicts;
+            read(Path, Merged);
+
+            nlohmann::json j(Merged);
+            std::string TempPath = Path + ".tmp";
+            {
+                std::ofstream OS(TempPath);
+                if (!OS.good())
+                {
+                    return;
+                }
+                OS << j.dump();
+            }
+            std::rename(TempPath.c_str(), Path.c_str());
+            Verdicts = Merged;
+            Dirty = false;
+            return;
+        }
+    }
+} // namespace Transformer
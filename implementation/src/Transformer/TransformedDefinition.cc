@@ -20,11 +20,13 @@ namespace Transformer
 
     TransformedDefinition::TransformedDefinition(
         ASTContext &Ctx,
-        MacroExpansionNode *Expansion)
+        MacroExpansionNode *Expansion,
+        Utils::TypeStringCache &TypeStrings)
         : Expansion(Expansion),
           OriginalMacroName(Expansion->getName()),
           IsVar(transformsToVar(Expansion, Ctx)),
-          VarOrReturnType(getDesugaredCanonicalType(Ctx, *(Expansion->getStmts().begin())))
+          VarOrReturnType(getDesugaredCanonicalType(Ctx, *(Expansion->getStmts().begin()))),
+          TypeStrings(TypeStrings)
     {
         for (auto &&Arg : Expansion->getArguments())
         {
@@ -46,12 +48,37 @@ namespace Transformer
     }
 
     string TransformedDefinition::getEmittedName() { return EmittedName; }
-    void TransformedDefinition::setEmittedName(string s) { EmittedName = s; }
+    void TransformedDefinition::setEmittedName(string s)
+    {
+        EmittedName = s;
+        SignatureWithName = "";
+    }
     MacroExpansionNode *TransformedDefinition::getExpansion() { return Expansion; }
 
     std::string TransformedDefinition::getExpansionSignatureOrDeclaration(
         ASTContext &Ctx,
         bool includeEmittedName)
+    {
+        if (!SignatureComputed)
+        {
+            computeSignature(Ctx);
+            SignatureComputed = true;
+        }
+
+        if (!includeEmittedName)
+        {
+            return SignatureNoName;
+        }
+
+        if (SignatureWithName == "")
+        {
+            SignatureWithName = SignatureNoName;
+            SignatureWithName.insert(EmittedNameIndex, " " + EmittedName);
+        }
+        return SignatureWithName;
+    }
+
+    void TransformedDefinition::computeSignature(ASTContext &Ctx)
     {
         assert(expansionHasUnambiguousSignature(Ctx, Expansion));
 
@@ -63,7 +90,7 @@ namespace Transformer
             // TODO: Maybe we should remove const here as well?
             QualType ReturnTypePointeeType = getPointeeType(VarOrReturnType);
             auto RTPT = ReturnTypePointeeType.getTypePtr();
-            string TString = VarOrReturnType.getAsString();
+            string TString = TypeStrings.getAsString(VarOrReturnType);
             // Add struct/union/enum before type name if not present
             if (RTPT->isStructureType() &&
                 TString.find("struct") == string::npos)
@@ -84,25 +111,24 @@ namespace Transformer
             Signature = TString;
         }
 
-        if (includeEmittedName)
-        {
-            Signature += " " + EmittedName;
-        }
+        // The emitted name goes between the type and the formal params
+        EmittedNameIndex = Signature.length();
 
         // If it's not a var, then add formal params
         if (!this->IsVar)
         {
             Signature += "(";
             unsigned i = 0;
-            for (auto &&Arg : Expansion->getArguments())
+            for (auto &&Arg : Expansion->getArgumentsRef())
             {
                 if (i >= 1)
                 {
                     Signature += ", ";
                 }
-                auto ST = *(Arg.getStmts().begin());
-                QualType ArgType = getDesugaredCanonicalType(Ctx, ST);
-                string TString = ArgType.getAsString();
+                // The arg types were computed from each argument's first
+                // stmt when this definition was created
+                QualType ArgType = ArgTypes[i];
+                string TString = TypeStrings.getAsString(ArgType);
 
                 // TODO: This is a hack
                 // Manually remove const qualifiers from parameters only
@@ -140,7 +166,8 @@ namespace Transformer
             }
             Signature += ")";
         }
-        return Signature;
+
+        SignatureNoName = Signature;
     }
 
     std::vector<clang::QualType> TransformedDefinition::getTypesInSignature()
@@ -1,4 +1,4 @@
-#include "Transformer/Properties.hh"
+#include "Transformer/PropertyPipeline.hh"
 #include "Callbacks/MacroNameCollector.hh"
 #include "Callbacks/IncludeCollector.hh"
 #include "Utils/Logging/TransformerMessages.hh"
@@ -6,6 +6,7 @@
 #include "Transformer/TransformerConsumer.hh"
 #include "Transformer/TransformerSettings.hh"
 #include "Utils/TransformedDeclarationAnnotation.hh"
+#include "Utils/EditList.hh"
 #include "Utils/ExpansionUtils.hh"
 #include "CppSig/MacroExpansionNode.hh"
 #include "CppSig/CppSigUtils.hh"
@@ -15,12 +16,16 @@
 #include "Visitors/DeclRangeVisitor.hh"
 
 #include "clang/ASTMatchers/ASTMatchFinder.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Tooling/ReplacementsYaml.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <memory>
 
 namespace Transformer
 {
@@ -33,18 +38,28 @@ namespace Transformer
     using namespace Visitors;
     using namespace Callbacks;
 
-    string SYNTAX = "Syntactic well-formedness",
-           ENVIRONMENT_CAPTURE = "Environment capture",
-           PARAMETER_SIDE_EFFECTS = "Parameter side-effects",
-           UNSUPPORTED_CONSTRUCT = "Unsupported construct",
-           TURNED_OFF_CONSTRUCT = "Turned off construct";
-
     TransformerConsumer::TransformerConsumer(
         CompilerInstance *CI,
-        TransformerSettings TSettings)
+        TransformerSettings TSettings,
+        std::shared_ptr<Utils::UniqueNameGenerator> Names,
+        TransformationResult *Result,
+        std::shared_ptr<SignatureVerdictCache> VerdictCache,
+        std::shared_ptr<Utils::AnnotationManifest> Manifest)
         : CI(CI),
-          TSettings(TSettings)
+          TSettings(TSettings),
+          VerdictCache(VerdictCache),
+          Manifest(Manifest),
+          Names(Names ? Names : std::make_shared<Utils::UniqueNameGenerator>()),
+          Result(Result),
+          Pipeline(TSettings)
     {
+        // The budget includes parsing, so start it before anything is parsed
+        if (TSettings.HasTUBudget)
+        {
+            TUDeadline = std::chrono::steady_clock::now() +
+                         std::chrono::milliseconds(TSettings.TUBudgetMs);
+        }
+
         // In the constructor, set up the preprocessor callbacks that
         // will be needed during the transformation
         Preprocessor &PP = CI->getPreprocessor();
@@ -62,6 +77,23 @@ namespace Transformer
         PP.addPPCallbacks(unique_ptr<PPCallbacks>(MNC));
         PP.addPPCallbacks(unique_ptr<PPCallbacks>(MF));
         PP.addPPCallbacks(unique_ptr<PPCallbacks>(IC));
+
+        if (!this->VerdictCache)
+        {
+            this->VerdictCache = std::make_shared<SignatureVerdictCache>();
+            if (TSettings.VerdictCachePath != "")
+            {
+                this->VerdictCache->load(TSettings.VerdictCachePath);
+            }
+        }
+        if (!this->Manifest)
+        {
+            this->Manifest = std::make_shared<Utils::AnnotationManifest>();
+            if (TSettings.AnnotationManifestPath != "")
+            {
+                this->Manifest->load(TSettings.AnnotationManifestPath);
+            }
+        }
     }
 
     void TransformerConsumer::debugMsg(std::string s)
@@ -72,12 +104,24 @@ namespace Transformer
         }
     }
 
+    void TransformerConsumer::reportFailure(ASTContext &Ctx, const std::string &Msg)
+    {
+        DiagnosticsEngine &DE = Ctx.getDiagnostics();
+        unsigned ID = DE.getCustomDiagID(DiagnosticsEngine::Error, "cpp2c: %0");
+        DE.Report(ID) << Msg;
+        if (!Result && TSettings.EmitMode == EMIT_FILES && !TSettings.OverwriteFiles)
+        {
+            SourceManager &SM = Ctx.getSourceManager();
+            outs() << SM.getBufferData(SM.getMainFileID());
+        }
+    }
+
     void TransformerConsumer::HandleTranslationUnit(ASTContext &Ctx)
     {
-        Rewriter RW;
         SourceManager &SM = Ctx.getSourceManager();
         const LangOptions &LO = Ctx.getLangOpts();
-        RW.setSourceMgr(SM, LO);
+        // All edits are collected first and applied to each file at the end
+        Utils::EditList Edits(SM, LO);
         Preprocessor &PP = CI->getPreprocessor();
 
         TranslationUnitDecl *TUD = Ctx.getTranslationUnitDecl();
@@ -119,12 +163,18 @@ namespace Transformer
                 {
                     // Get this decl's first annotation
                     std::string annotation = Utils::getFirstAnnotationOrEmpty(D);
-                    nlohmann::json j = Utils::annotationStringToJson(annotation);
 
-                    // Create the unique macro hash based on data in
-                    // the JSON object
+                    // Parse the annotation, or look it up in the manifest
+                    // if it is compact. Compact annotations which are not
+                    // in the manifest can't be deduplicated against
                     Utils::TransformedDeclarationAnnotation TDA;
-                    Utils::from_json(j, TDA);
+                    if (!Manifest->lookup(annotation, TDA))
+                    {
+                        continue;
+                    }
+
+                    // Create the unique macro hash based on data in
+                    // the annotation
                     std::string MacroHash = Utils::hashTDAOriginalMacro(TDA);
                     std::string TDAHash = Utils::hashTDA(TDA);
 
@@ -149,15 +199,14 @@ namespace Transformer
 
         // Collect the names of all the variables, functions, and macros
         // defined in the program
-        set<string> UsedSymbols;
         {
             set<string> FunctionNames;
             set<string> VarNames;
             CollectDeclNamesVisitor CDNvisitor(CI, &FunctionNames, &VarNames);
             CDNvisitor.TraverseTranslationUnitDecl(TUD);
-            UsedSymbols.insert(FunctionNames.begin(), FunctionNames.end());
-            UsedSymbols.insert(VarNames.begin(), VarNames.end());
-            UsedSymbols.insert(MacroNames.begin(), MacroNames.end());
+            Names->addUsedSymbols(FunctionNames);
+            Names->addUsedSymbols(VarNames);
+            Names->addUsedSymbols(MacroNames);
         }
         debugMsg("Done collecting used symbol names\n");
 
@@ -174,11 +223,10 @@ namespace Transformer
         std::set<std::string> AllowedMacroDefFileRealPaths;
         {
 
-            // Collect decl ranges
+            // Collect top-level decl ranges
             debugMsg("Collecting decl ranges\n");
             Visitors::DeclRangeVisitor DRV(Ctx);
             DRV.TraverseTranslationUnitDecl(TUD);
-            auto &DeclRanges = DRV.getDeclRangesRef();
             debugMsg("Done collecting decl ranges\n");
 
             // Initially allow all files
@@ -188,31 +236,28 @@ namespace Transformer
             }
 
             debugMsg("Removing all #includes inside decls\n");
-            // Remove files #include'd inside decls
+            // Remove files #include'd inside decls.
+            // The decl ranges are sorted once, so each include location
+            // only needs a binary search instead of a scan over every decl
             for (auto &&it : IncludeLocToFileRealPath)
             {
                 clang::SourceLocation Loc = it.first;
-                for (auto DeclRange : DeclRanges)
+                if (auto DeclRange = DRV.findDeclRangeContaining(Loc))
                 {
-                    auto B = DeclRange.getBegin();
-                    auto E = DeclRange.getEnd();
-                    if (B <= Loc && Loc <= E)
+                    if (TSettings.Verbose)
                     {
-                        if (TSettings.Verbose)
-                        {
-                            debugMsg(
-                                "Erasing " +
-                                it.second +
-                                " because its include location is\n");
-                            Loc.dump(SM);
-                            llvm::errs() << "between\n";
-                            B.dump(SM);
-                            llvm::errs() << "and\n";
-                            E.dump(SM);
-                        }
-                        
-                        AllowedMacroDefFileRealPaths.erase(it.second);
+                        debugMsg(
+                            "Erasing " +
+                            it.second +
+                            " because its include location is\n");
+                        Loc.dump(SM);
+                        llvm::errs() << "between\n";
+                        DeclRange->getBegin().dump(SM);
+                        llvm::errs() << "and\n";
+                        DeclRange->getEnd().dump(SM);
                     }
+
+                    AllowedMacroDefFileRealPaths.erase(it.second);
                 }
             }
 
@@ -251,15 +296,47 @@ namespace Transformer
         }
         for (auto ST : *ExpansionASTRoots)
         {
+            // Expansions whose statements aren't found are rejected for
+            // exceeding the budget in step 3
+            if (std::chrono::steady_clock::now() >= TUDeadline)
+            {
+                debugMsg("Time budget exceeded in step 2\n");
+                break;
+            }
             populateExpansionsWhoseTopLevelStmtIsThisStmt(ST, ExpansionRoots, Ctx);
         }
 
-        // Step 3 : Within Subtrees, Match the Arguments
+        std::vector<std::unique_ptr<PropertyCheckContext>> CheckContexts;
+        for (auto TopLevelExpansion : ExpansionRoots)
+        {
+            CheckContexts.emplace_back(new PropertyCheckContext(
+                TopLevelExpansion, Ctx, PP,
+                AllowedMacroDefFileRealPaths,
+                *VerdictCache,
+                TypeStrings));
+            CheckContexts.back()->TUDeadline = TUDeadline;
+        }
+
+        // Step 3 : Within Subtrees, Match the Arguments.
+        // The time this takes counts towards each expansion's budget.
+        // Matching an expansion's arguments can't be stopped partway, so
+        // an expansion is only rejected for running out of time once its
+        // matching is done
         if (TSettings.Verbose)
         {
             errs() << "Step 3: Find Arguments \n";
         }
-        matchArguments(Ctx, ExpansionRoots);
+        for (auto &&it : CheckContexts)
+        {
+            if (Pipeline.rejectIfOverBudget(*it))
+            {
+                continue;
+            }
+            auto Start = std::chrono::steady_clock::now();
+            matchArguments(Ctx, it->Expansion);
+            it->AnalysisTime += std::chrono::steady_clock::now() - Start;
+            Pipeline.rejectIfOverBudget(*it);
+        }
 
         // Emit potentially transformable expansions
         if (TSettings.Verbose)
@@ -278,85 +355,144 @@ namespace Transformer
         // 3) No side-effects in parameters
         // 4) Not turned off (e.g., conditional evaluation)
         // 5) Not unsupported (e.g., not L-value independent, Clang doesn't support rewriting, etc.)
+        // See PropertyPipeline for the order these are checked in
         if (TSettings.Verbose)
         {
             errs() << "Step 4: Transform hygienic and transformable macros \n";
         }
 
-        for (auto TopLevelExpansion : ExpansionRoots)
+        // Find the forward declarations emitted by earlier runs, so that
+        // no tag type is forward declared more than once per file.
+        // New declarations are emitted after the last of these in each
+        // file, so that the forward declarations precede them
+        std::map<clang::FileID, std::set<const clang::Type *>> ForwardDeclaredTagTypes;
+        std::map<clang::FileID, clang::SourceLocation> DeclarationInsertionLocs;
+        for (auto &&D : TUD->decls())
         {
-            // Syntactic well-formedness
-            string errMsg = isWellFormed(TopLevelExpansion, Ctx, PP);
-            if (errMsg != "")
+            if (!Utils::isCpp2CForwardDeclaration(D))
             {
-                if (TSettings.Verbose)
-                {
-                    emitUntransformedMessage(errs(), Ctx, TopLevelExpansion, SYNTAX, errMsg);
-                }
                 continue;
             }
-
-            // Environment capture
-            errMsg = isEnvironmentCapturing(TopLevelExpansion, Ctx);
-            if (errMsg != "")
+            auto Loc = SM.getFileLoc(D->getEndLoc());
+            clang::FileID FID = SM.getFileID(Loc);
+            auto TagType = Ctx.getTagDeclType(clang::cast<clang::TagDecl>(D));
+            ForwardDeclaredTagTypes[FID].insert(TagType.getCanonicalType().getTypePtr());
+
+            auto AfterSemi = clang::Lexer::findLocationAfterToken(
+                Loc, clang::tok::semi, SM, LO, true);
+            if (AfterSemi.isValid() &&
+                (DeclarationInsertionLocs.find(FID) == DeclarationInsertionLocs.end() ||
+                 SM.isBeforeInTranslationUnit(DeclarationInsertionLocs[FID], AfterSemi)))
             {
-                if (TSettings.Verbose)
-                {
-                    emitUntransformedMessage(errs(), Ctx, TopLevelExpansion, ENVIRONMENT_CAPTURE, errMsg);
-                }
-                continue;
+                DeclarationInsertionLocs[FID] = AfterSemi;
             }
+        }
+        // Forward declarations to emit in each file, in the order they
+        // were first needed
+        std::map<clang::FileID, std::vector<std::string>> PendingForwardDecls;
+
+        unsigned TransformedExpansions = 0;
 
-            // Parameter side-effects and L-Value Independence
-            errMsg = isParamSEFreeAndLValueIndependent(TopLevelExpansion, Ctx);
-            if (errMsg != "")
+        // Analysis phase: Run the property checks that only read the AST
+        // for all expansions in parallel. This doesn't change the
+        // output, since the remaining checks and all the rewriting are
+        // done serially in the original order below
+        if (TSettings.Jobs != 1 && CheckContexts.size() > 1)
+        {
+            debugMsg("Analyzing expansions in parallel\n");
+            // The parent map is built lazily, so build it before any
+            // threads need it
+            Ctx.getParents(*TUD);
+            llvm::ThreadPool Pool(llvm::hardware_concurrency(TSettings.Jobs));
+            for (auto &&it : CheckContexts)
             {
-                if (TSettings.Verbose)
-                {
-                    emitUntransformedMessage(errs(), Ctx, TopLevelExpansion, PARAMETER_SIDE_EFFECTS, errMsg);
-                }
-                continue;
+                PropertyCheckContext *PCC = it.get();
+                Pool.async([this, PCC]
+                           { Pipeline.run(*PCC, TSettings.Verbose, true); });
             }
+            Pool.wait();
+            debugMsg("Done analyzing expansions in parallel\n");
+        }
 
-            // Turned off construct
-            // Currently the only construct that can be toggled is
-            // conditional evaluation (i.e., &&, ||, and ternary).
-            // This is turned off to prevent the accidental introduction
-            // of undefined behavior
-            if (!TSettings.TransformConditionalEvaluation)
+        // Returns the annotation to emit on a transformed declaration.
+        // With a manifest, the full annotation is recorded there, and only
+        // its compact ID is emitted
+        auto getAnnotationString = [this](const TransformedDeclarationAnnotation &TDA)
+        {
+            if (TSettings.AnnotationManifestPath != "")
             {
-                if (auto E = clang::dyn_cast_or_null<clang::Expr>(*TopLevelExpansion->getStmtsRef().begin()))
-                {
-                    if (Utils::containsConditionalEvaluation(E))
-                    {
-                        if (TSettings.Verbose)
-                        {
-                            emitUntransformedMessage(errs(), Ctx, TopLevelExpansion, TURNED_OFF_CONSTRUCT, "Conditional evaluation turned off");
-                        }
-                        continue;
-                    }
-                }
+                return Manifest->insert(TDA);
             }
+            nlohmann::json j;
+            Utils::to_json(j, TDA);
+            return j.dump();
+        };
+
+        // Maps macro hash plus signature to the names of the enum constants
+        // emitted for them in this run. Enum constants have no separate
+        // declaration, so they can only be shared with later expansions
+        // in the same run
+        std::map<std::string, std::string> MHashPlusSigToEnumConstantName;
+
+        // Maps the content key of each expansion transformed in this run
+        // to the profiles of their expressions and the names emitted for
+        // them, for deduplicating by content
+        std::map<std::string, std::vector<std::pair<llvm::FoldingSetNodeID, std::string>>> ContentKeyToEmittedNames;
+
+        // Check the remaining properties of every expansion, cheapest first,
+        // before committing any of them, so that whether the translation
+        // unit ran out of time is known before anything is rewritten.
+        // Only attribute rejections to categories in verbose mode,
+        // since that is the only mode in which they are reported
+        for (auto &&it : CheckContexts)
+        {
+            Pipeline.run(*it, TSettings.Verbose);
+        }
+
+        // A translation unit that ran out of time is left as it was, so
+        // that no files are written after its deadline.
+        // Its expansions are still reported, with those that passed
+        // every check rejected for exceeding the budget
+        bool TUBudgetExceeded = std::chrono::steady_clock::now() >= TUDeadline;
+        if (TUBudgetExceeded)
+        {
+            debugMsg("Time budget exceeded before any expansion was committed\n");
+        }
 
-            // Create the transformed definition
-            TransformedDefinition *TD = new TransformedDefinition(Ctx, TopLevelExpansion);
+        // Commit phase
+        for (auto &&it : CheckContexts)
+        {
+            PropertyCheckContext &PCC = *it;
+            CppSig::MacroExpansionNode *TopLevelExpansion = PCC.Expansion;
 
-            // Unsupported constructs
-            errMsg = isUnsupportedConstruct(TD, Ctx, RW, AllowedMacroDefFileRealPaths);
-            if (errMsg != "")
+            if (TUBudgetExceeded && PCC.Verdict.passed())
+            {
+                Pipeline.rejectIfOverBudget(PCC);
+            }
+            PropertyVerdict Verdict = PCC.Verdict;
+            if (!Verdict.passed())
             {
                 if (TSettings.Verbose)
                 {
-                    emitUntransformedMessage(errs(), Ctx, TopLevelExpansion, UNSUPPORTED_CONSTRUCT, errMsg);
+                    emitUntransformedMessage(errs(), Ctx, TopLevelExpansion, Verdict.Category, Verdict.Reason);
                 }
-                // IMPORTANT.
-                // TODO: Change unsupported construct to accept a
-                // MacroExpansionNode instead of a TransformedDefinition
-                // so that we don't need this delete
-                delete TD;
                 continue;
             }
 
+            // The transformed definition is owned by the check context
+            TransformedDefinition *TD = PCC.getTD();
+
+            // Integer constants may be emitted as constants instead of
+            // as plain variables
+            bool EmitAsEnumConstant =
+                TD->IsVar &&
+                TSettings.ConstantMode == CONSTANTS_ENUM &&
+                transformsToEnumConstant(TopLevelExpansion, Ctx);
+            bool EmitAsConstVar =
+                TD->IsVar && !EmitAsEnumConstant &&
+                TSettings.ConstantMode != CONSTANTS_VARS &&
+                transformsToIntegerConstant(TopLevelExpansion, Ctx);
+
             //// Transform the expansion
             // 1.   Generate a unique name for the transformed declaration
             // 2.   Emit the transformed declaration at the start of the file
@@ -379,16 +515,28 @@ namespace Transformer
                 .TransformedDefinitionRealPaths = realPaths,
                 .TransformedSignature = TD->getExpansionSignatureOrDeclaration(Ctx, false),
             };
-            nlohmann::json j;
-            Utils::to_json(j, TDA);
             std::string MacroHash = Utils::hashTDAOriginalMacro(TDA);
             std::string EmittedName = "";
 
             debugMsg("Trying to find an already-emitted name for " + MacroHash + "\n");
             bool foundPreviousDecl = false;
             bool previousDeclInSameFile = false;
-            // Try to find an already-emitted name for this transformation
-            if (TSettings.DeduplicateWhileTransforming)
+            // Try to find an already-emitted name for this transformation.
+            // Enum constants are only shared with those emitted earlier
+            // in this run, since the declarations from prior runs may be
+            // variables, which can't be used where constant expressions
+            // are required
+            if (TSettings.DeduplicateWhileTransforming && EmitAsEnumConstant)
+            {
+                auto it = MHashPlusSigToEnumConstantName.find(MacroHash + TDA.TransformedSignature);
+                if (it != MHashPlusSigToEnumConstantName.end())
+                {
+                    EmittedName = it->second;
+                    foundPreviousDecl = true;
+                    previousDeclInSameFile = true;
+                }
+            }
+            else if (TSettings.DeduplicateWhileTransforming)
             {
                 if (MHashToAllTransformedSigs.find(MacroHash) !=
                     MHashToAllTransformedSigs.end())
@@ -419,25 +567,88 @@ namespace Transformer
                 }
             }
             debugMsg("Done trying to find an emitted name for " + MacroHash + "\n");
+
+            // Try to find an equivalent transformation of a different macro.
+            // Its definition must be declared in the same file as this one
+            // would be, so that the declaration precedes every expansion of
+            // this macro.
+            // Enum constants have no separate declaration, so they are
+            // not shared
+            string ContentKey = "";
+            llvm::FoldingSetNodeID ContentProfile;
+            if (TSettings.DeduplicateByContent && !EmitAsEnumConstant)
+            {
+                auto DeclFID = SM.getFileID(TD->getTransformedDeclarationLocation(Ctx));
+                ContentKey = to_string(DeclFID.getHashValue()) + "\t" +
+                             (TD->IsVar ? "var" : "function") + "\t" +
+                             (EmitAsConstVar ? "const" : "") + "\t" +
+                             getParameterIndependentDefinitionText(TopLevelExpansion, SM, LO);
+                for (auto &&T : TD->getTypesInSignature())
+                {
+                    ContentKey += "\t" + TypeStrings.getAsString(T);
+                }
+                // Equal definition texts may still parse differently,
+                // e.g., if a macro they expand was redefined
+                profileExpansionWithoutArguments(Ctx, TopLevelExpansion, ContentProfile);
+
+                if (EmittedName == "")
+                {
+                    for (auto &&Previous : ContentKeyToEmittedNames[ContentKey])
+                    {
+                        if (Previous.first == ContentProfile)
+                        {
+                            // The equivalent transformation was declared
+                            // and defined when it was transformed
+                            EmittedName = Previous.second;
+                            foundPreviousDecl = true;
+                            previousDeclInSameFile = true;
+                            break;
+                        }
+                    }
+                }
+            }
             // Generate a unique name for this transformed macro if we haven't found one yet,
             // and add it to the appropriate mappings
-            if (EmittedName == "")
+            if (EmittedName == "" && EmitAsEnumConstant)
+            {
+                EmittedName = Names->getUniqueName(TopLevelExpansion->getName(),
+                                                   MacroHash,
+                                                   TDA.TransformedSignature,
+                                                   TD->IsVar);
+                MHashPlusSigToEnumConstantName[MacroHash + TDA.TransformedSignature] = EmittedName;
+            }
+            else if (EmittedName == "")
             {
                 debugMsg("Generating a unique decl for " + MacroHash + "\n");
                 auto Sig = TDA.TransformedSignature;
                 auto MHashPlusSig = MacroHash + Sig;
-                EmittedName = getUniqueNameForExpansionTransformation(TopLevelExpansion, UsedSymbols, Ctx);
+                EmittedName = Names->getUniqueName(TopLevelExpansion->getName(),
+                                                   MacroHash,
+                                                   Sig,
+                                                   TD->IsVar);
                 MHashToAllTransformedSigs[MacroHash].insert(TDA.TransformedSignature);
                 MHashPlusSigToName[MHashPlusSig] = EmittedName;
                 // Only 1 realpath at this point, so we do an unconditional dereference
                 MHashPlusSigToDefRealPaths[MHashPlusSig].insert(*TDA.TransformedDefinitionRealPaths.begin());
                 debugMsg("Done generating a unique decl for " + MacroHash + "\n");
             }
-            UsedSymbols.insert(EmittedName);
-            TD->EmittedName = EmittedName;
+            Names->addUsedSymbol(EmittedName);
+            TD->setEmittedName(EmittedName);
+
+            if (ContentKey != "")
+            {
+                auto &Previous = ContentKeyToEmittedNames[ContentKey];
+                if (std::none_of(Previous.begin(), Previous.end(),
+                                 [&](const std::pair<llvm::FoldingSetNodeID, std::string> &P)
+                                 { return P.first == ContentProfile; }))
+                {
+                    Previous.emplace_back(ContentProfile, EmittedName);
+                }
+            }
 
-            // Emit declaration if we did not find a decl for this transformation yet
-            if (!foundPreviousDecl)
+            // Emit declaration if we did not find a decl for this transformation yet.
+            // Enum constants are declared where they are defined
+            if (!foundPreviousDecl && !EmitAsEnumConstant)
             {
                 // Create the full declaration
                 // Add the static keyword to the start of the declaration
@@ -446,21 +657,28 @@ namespace Transformer
                 // Write the new decl
                 std::ostringstream transformedDefinition;
                 transformedDefinition
-                    << "static "
+                    << (EmitAsConstVar ? "static const " : "static ")
                     << TD->getExpansionSignatureOrDeclaration(Ctx, true)
                     << "\n"
                     << "    __attribute__((annotate(\""
-                    << escape_json(j.dump())
+                    << escape_json(getAnnotationString(TDA))
                     << "\")));\n\n";
 
                 // Can only get this from a macro defined callback
                 auto TransformedDeclarationLoc = TD->getTransformedDeclarationLocation(Ctx);
-                bool rewriteFailed = RW.InsertTextBefore(
+                clang::FileID DeclFID = SM.getFileID(TransformedDeclarationLoc);
+                if (DeclarationInsertionLocs.find(DeclFID) != DeclarationInsertionLocs.end())
+                {
+                    TransformedDeclarationLoc = DeclarationInsertionLocs[DeclFID];
+                }
+                bool rewriteFailed = Edits.insertTextBefore(
                     TransformedDeclarationLoc,
-                    StringRef(transformedDefinition.str()));
+                    StringRef(transformedDefinition.str()),
+                    "declaration\t" + MacroHash + "\t" + TDA.TransformedSignature);
                 assert(!rewriteFailed);
 
-                // Forward declare structs/unions/enums in signature
+                // Forward declare structs/unions/enums in signature,
+                // unless they have already been forward declared in this file
                 auto structNamesInSignature = TD->getStructUnionEnumTypesInSignature();
                 for (auto &&it : structNamesInSignature)
                 {
@@ -471,6 +689,11 @@ namespace Transformer
                     {
                         assert(false && "nullptr error");
                     }
+                    QualType FwdDeclType = it.getDesugaredType(Ctx).getCanonicalType().getUnqualifiedType();
+                    if (!ForwardDeclaredTagTypes[DeclFID].insert(FwdDeclType.getTypePtr()).second)
+                    {
+                        continue;
+                    }
                     string prefix = (T->isStructureType()
                                          ? "struct"
                                      : T->isUnionType() ? "union"
@@ -479,7 +702,7 @@ namespace Transformer
                     string annotation = " __attribute__((annotate(\"CPP2C\"))) ";
 
                     string annotatedFwdDecl = "";
-                    string typeString = it.getDesugaredType(Ctx).getCanonicalType().getUnqualifiedType().getAsString();
+                    string typeString = TypeStrings.getAsString(FwdDeclType);
                     size_t prefixLoc = typeString.find(prefix);
                     if (prefixLoc != string::npos)
                     {
@@ -493,10 +716,7 @@ namespace Transformer
                         // it as well at the start of the forward declaration
                         annotatedFwdDecl = typeString.insert(0, prefix + annotation);
                     }
-                    auto failed = RW.InsertTextBefore(
-                        SM.getLocForStartOfFile(SM.getFileID(TransformedDeclarationLoc)),
-                        StringRef(annotatedFwdDecl + ";\n\n"));
-                    assert(!failed);
+                    PendingForwardDecls[DeclFID].push_back(annotatedFwdDecl);
                 }
             }
 
@@ -520,9 +740,10 @@ namespace Transformer
                     }
                     CallOrRef += ")";
                 }
-                bool rewriteFailed = RW.ReplaceText(
+                bool rewriteFailed = Edits.replaceText(
                     TD->getInvocationReplacementRange(), StringRef(CallOrRef));
                 assert(!rewriteFailed);
+                TransformedExpansions += 1;
 
                 auto FD = Utils::getTopLevelNamedDeclStmtExpandedIn(Ctx, (*TopLevelExpansion->getStmtsRef().begin()));
                 assert(FD != nullptr);
@@ -541,12 +762,35 @@ namespace Transformer
                 // Emit each transformed definition before the
                 // definition of the function in which it is called.
                 string TransformedSignature = TD->getExpansionSignatureOrDeclaration(Ctx, true);
-                string FullTransformationDefinition = "static " + TransformedSignature + TD->InitializerOrDefinition;
+                // Only functions can be inlined; the declaration emitted
+                // earlier stays plain static, which C allows
+                string StorageSpecifiers = "static ";
+                if (EmitAsConstVar)
+                {
+                    StorageSpecifiers = "static const ";
+                }
+                else if (!TD->IsVar && TSettings.InlineMode == INLINE_HINT)
+                {
+                    StorageSpecifiers = "static inline ";
+                }
+                else if (!TD->IsVar && TSettings.InlineMode == INLINE_ALWAYS)
+                {
+                    StorageSpecifiers = "static inline __attribute__((always_inline)) ";
+                }
+                string FullTransformationDefinition = StorageSpecifiers + TransformedSignature + TD->InitializerOrDefinition;
+                if (EmitAsEnumConstant)
+                {
+                    // The enum constant carries the annotation itself
+                    FullTransformationDefinition =
+                        "enum { " + TD->getEmittedName() +
+                        "\n    __attribute__((annotate(\"" + escape_json(getAnnotationString(TDA)) + "\")))" +
+                        " = " + TopLevelExpansion->getDefinitionText() + " };";
+                }
 
                 // NOTE: This has some coupling with an earlier check
                 // that the spelling location of the start of the function decl
                 // is rewritable
-                bool rewriteFailed = RW.InsertTextBefore(
+                bool rewriteFailed = Edits.insertTextBefore(
                     TD->getTransformedDefinitionLocation(Ctx),
                     StringRef(FullTransformationDefinition + "\n\n"));
                 assert(!rewriteFailed);
@@ -554,15 +798,32 @@ namespace Transformer
                 {
                     emitTransformedDefinitionMessage(errs(), TD, Ctx, SM, LO);
                 }
-                if (TSettings.DeduplicateWhileTransforming)
+                if (TSettings.DeduplicateWhileTransforming && !EmitAsEnumConstant)
                 {
                     auto MHashPlusSig = MacroHash + TDA.TransformedSignature;
                     MHashPlusSigToDefRealPaths[MHashPlusSig].insert(*TDA.TransformedDefinitionRealPaths.begin());
                 };
             }
+        }
 
-            // Free the TransformedDefinition object since it is no longer needed at this point
-            delete TD;
+        // Emit the new forward declarations last, so that they precede
+        // all the declarations emitted at the same location
+        for (auto &&it : PendingForwardDecls)
+        {
+            auto FwdDeclLoc = SM.getLocForStartOfFile(it.first);
+            if (DeclarationInsertionLocs.find(it.first) != DeclarationInsertionLocs.end())
+            {
+                FwdDeclLoc = DeclarationInsertionLocs[it.first];
+            }
+            // Insert in reverse, since each insertion goes before the last
+            for (auto FwdDecl = it.second.rbegin(); FwdDecl != it.second.rend(); ++FwdDecl)
+            {
+                auto failed = Edits.insertTextBefore(
+                    FwdDeclLoc,
+                    StringRef(*FwdDecl + ";\n\n"),
+                    "forward declaration\t" + *FwdDecl);
+                assert(!failed);
+            }
         }
 
         // Finally, update any declarations which had new definition realpaths added to them
@@ -599,35 +860,161 @@ namespace Transformer
 
                             auto Attr = clang::dyn_cast<clang::AnnotateAttr>(*D->attrs().begin());
 
-                            nlohmann::json j;
-                            Utils::to_json(j, NewTDA);
-                            auto newAnnotationString = "annotate(\"" + Utils::escape_json(j.dump()) + "\")";
+                            // Compact annotations don't change when definitions
+                            // are added, only their records in the manifest do
+                            auto newAnnotation = getAnnotationString(NewTDA);
+                            if (Attr->getAnnotation() != newAnnotation)
+                            {
+                                auto newAnnotationString = "annotate(\"" + Utils::escape_json(newAnnotation) + "\")";
 
-                            // Replace the old annotation with the new one
-                            auto failed = RW.ReplaceText(Attr->getRange(), llvm::StringRef(newAnnotationString));
-                            assert(!failed);
+                                // Replace the old annotation with the new one
+                                auto failed = Edits.replaceText(Attr->getRange(),
+                                                                llvm::StringRef(newAnnotationString),
+                                                                "annotation\t" + MacroHash + "\t" + Sig);
+                                assert(!failed);
+                            }
                         }
                     }
                 }
             }
         }
 
-        if (TSettings.OverwriteFiles)
+        if (TUBudgetExceeded)
         {
-            RW.overwriteChangedFiles();
+            if (Result)
+            {
+                Result->BudgetExceeded = true;
+            }
+            else if (TSettings.EmitMode == EMIT_FILES && !TSettings.OverwriteFiles)
+            {
+                outs() << SM.getBufferData(SM.getMainFileID());
+            }
+            return;
         }
-        else
+
+        std::string EditErr;
+        if (!Edits.validate(EditErr))
         {
-            // Print the results of the rewriting for the current file
-            if (const RewriteBuffer *RewriteBuf = RW.getRewriteBufferFor(SM.getMainFileID()))
+            reportFailure(Ctx, "could not apply edits: " + EditErr);
+            return;
+        }
+
+        if (Result)
+        {
+            // Iterations of the fixed-point driver only record their result,
+            // which the consumer that started the driver writes out
+            Result->TransformedExpansions = TransformedExpansions;
+            for (auto &&FID : Edits.getEditedFiles())
+            {
+                Result->RewrittenFiles[Edits.getFilePath(FID)] = Edits.getRewrittenBuffer(FID);
+            }
+            return;
+        }
+
+        if (TSettings.FixedPoint)
+        {
+            TransformationResult FirstResult;
+            FirstResult.TransformedExpansions = TransformedExpansions;
+            for (auto &&FID : Edits.getEditedFiles())
+            {
+                FirstResult.RewrittenFiles[Edits.getFilePath(FID)] = Edits.getRewrittenBuffer(FID);
+            }
+
+            // Run the rest of the iterations, then write out the last one's
+            // files the same way a single run writes its own
+            FixedPointDriver Driver(*CI, TSettings, Names, VerdictCache, Manifest, TUDeadline);
+            if (Driver.run(FirstResult))
+            {
+                reportFailure(Ctx, "failed to transform to a fixed point");
+                return;
+            }
+            if (Driver.budgetExceeded())
+            {
+                // As when a single run exceeds the budget, nothing is
+                // written, including the cache and the manifest
+                if (!TSettings.OverwriteFiles)
+                {
+                    outs() << SM.getBufferData(SM.getMainFileID());
+                }
+                return;
+            }
+            if (TSettings.OverwriteFiles)
             {
-                RewriteBuf->write(outs());
+                if (Driver.flush())
+                {
+                    reportFailure(Ctx, "could not write the transformed files");
+                    return;
+                }
             }
             else
             {
-                RW.getEditBuffer(SM.getMainFileID()).write(outs());
+                auto MainFile = Driver.getRewrittenFile(Edits.getFilePath(SM.getMainFileID()));
+                if (MainFile)
+                {
+                    outs() << *MainFile;
+                }
+                else
+                {
+                    outs() << SM.getBufferData(SM.getMainFileID());
+                }
+            }
+        }
+        else if (TSettings.EmitMode == EMIT_REPLACEMENTS)
+        {
+            // Print the edits to every touched file in the format
+            // clang-apply-replacements reads
+            clang::tooling::TranslationUnitReplacements TUR;
+            TUR.MainSourceFile = Edits.getFilePath(SM.getMainFileID());
+            for (auto &&FID : Edits.getEditedFiles())
+            {
+                auto Reps = Edits.toReplacements(FID);
+                TUR.Replacements.insert(TUR.Replacements.end(), Reps.begin(), Reps.end());
+            }
+            llvm::yaml::Output YAML(outs());
+            YAML << TUR;
+        }
+        else if (TSettings.EmitMode == EMIT_PATCH)
+        {
+            for (auto &&FID : Edits.getEditedFiles())
+            {
+                outs() << Edits.toUnifiedDiff(FID);
+            }
+        }
+        else if (TSettings.OverwriteFiles && TSettings.HeaderEditsDir != "")
+        {
+            if (Edits.overwriteMainFileAndRecordOthers(TSettings.HeaderEditsDir))
+            {
+                reportFailure(Ctx, "could not write the transformed files");
+                return;
+            }
+        }
+        else if (TSettings.OverwriteFiles)
+        {
+            if (Edits.overwriteChangedFiles())
+            {
+                reportFailure(Ctx, "could not write the transformed files");
+                return;
             }
         }
+        else
+        {
+            // Print the results of the rewriting for the current file
+            outs() << Edits.getRewrittenBuffer(SM.getMainFileID());
+        }
+
+        // The cache and the manifest are shared by every iteration of the
+        // fixed-point driver, so they are only saved once all of them are
+        // done. The manifest is only saved once the files which refer to
+        // it have been written, so that it never records annotations that
+        // were not emitted
+        if (TSettings.VerdictCachePath != "")
+        {
+            VerdictCache->save(TSettings.VerdictCachePath);
+        }
+        if (TSettings.AnnotationManifestPath != "")
+        {
+            Manifest->save(TSettings.AnnotationManifestPath);
+        }
     }
 
 } // namespace Transformer
\ No newline at end of file
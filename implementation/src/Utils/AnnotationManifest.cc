@@ -0,0 +1,174 @@
+#include "Utils/AnnotationManifest.hh"
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace Utils
+{
+    // Prefix of every compact annotation. Starts with the marker that
+    // all Cpp2C annotations contain
+    static const std::string COMPACT_ANNOTATION_PREFIX = "CPP2C:";
+
+    std::string AnnotationManifest::getCompactAnnotation(
+        const TransformedDeclarationAnnotation &TDA)
+    {
+        // xxHash64 doesn't depend on the process or platform,
+        // so every translation unit computes the same ID
+        std::string Hex;
+        llvm::raw_string_ostream HexOS(Hex);
+        HexOS << llvm::format_hex_no_prefix(llvm::xxHash64(hashTDA(TDA)), 16);
+        HexOS.flush();
+        return COMPACT_ANNOTATION_PREFIX + Hex;
+    }
+
+    bool AnnotationManifest::isCompactAnnotation(llvm::StringRef Annotation)
+    {
+        return Annotation.startswith(COMPACT_ANNOTATION_PREFIX);
+    }
+
+    bool AnnotationManifest::merge(
+        std::map<std::string, TransformedDeclarationAnnotation> &Annotations,
+        const std::string &ID,
+        const TransformedDeclarationAnnotation &TDA)
+    {
+        auto Inserted = Annotations.emplace(ID, TDA);
+        if (Inserted.second)
+        {
+            return true;
+        }
+        auto &RealPaths = Inserted.first->second.TransformedDefinitionRealPaths;
+        auto OldSize = RealPaths.size();
+        RealPaths.insert(TDA.TransformedDefinitionRealPaths.begin(),
+                         TDA.TransformedDefinitionRealPaths.end());
+        return RealPaths.size() != OldSize;
+    }
+
+    std::string AnnotationManifest::insert(const TransformedDeclarationAnnotation &TDA)
+    {
+        std::string ID = getCompactAnnotation(TDA);
+        Dirty = merge(Annotations, ID, TDA) || Dirty;
+        return ID;
+    }
+
+    bool AnnotationManifest::lookup(
+        llvm::StringRef Annotation,
+        TransformedDeclarationAnnotation &TDA) const
+    {
+        if (!isCompactAnnotation(Annotation))
+        {
+            // Don't throw on a malformed annotation; just skip it
+            try
+            {
+                from_json(annotationStringToJson(Annotation.str()), TDA);
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+            return true;
+        }
+
+        auto it = Annotations.find(Annotation.str());
+        if (it == Annotations.end())
+        {
+            return false;
+        }
+        TDA = it->second;
+        return true;
+    }
+
+    void AnnotationManifest::read(
+        const std::string &Path,
+        std::map<std::string, TransformedDeclarationAnnotation> &Annotations)
+    {
+        std::ifstream IS(Path);
+        if (!IS.good())
+        {
+            return;
+        }
+
+        // Don't throw on a malformed manifest; just skip it
+        nlohmann::json j = nlohmann::json::parse(IS, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+        {
+            return;
+        }
+
+        for (auto &&it : j.items())
+        {
+            TransformedDeclarationAnnotation TDA;
+            try
+            {
+                from_json(it.value(), TDA);
+            }
+            catch (const nlohmann::json::exception &)
+            {
+                continue;
+            }
+            merge(Annotations, it.key(), TDA);
+        }
+    }
+
+    void AnnotationManifest::load(const std::string &Path)
+    {
+        read(Path, Annotations);
+    }
+
+    void AnnotationManifest::save(const std::string &Path)
+    {
+        if (!Dirty)
+        {
+            return;
+        }
+
+        while (true)
+        {
+            llvm::LockFileManager Lock(Path);
+            if (Lock.getState() == llvm::LockFileManager::LFS_Shared)
+            {
+                // Another translation unit is writing the manifest.
+                // If it takes too long, assume it died while holding
+                // the lock
+                if (Lock.waitForUnlock() == llvm::LockFileManager::Res_Timeout)
+                {
+                    Lock.unsafeRemoveLockFile();
+                }
+                continue;
+            }
+
+            // If the lock can't be created (LFS_Error), the manifest is
+            // still written, just without protection from other writers
+            std::map<std::string, TransformedDeclarationAnnotation> Merged;
+            read(Path, Merged);
+            for (auto &&it : Annotations)
+            {
+                merge(Merged, it.first, it.second);
+            }
+
+            nlohmann::json j = nlohmann::json::object();
+            for (auto &&it : Merged)
+            {
+                to_json(j[it.first], it.second);
+            }
+
+            std::string TempPath = Path + ".tmp";
+            {
+                std::ofstream OS(TempPath);
+                if (!OS.good())
+                {
+                    return;
+                }
+                OS << j.dump(2, ' ', false, nlohmann::json::error_handler_t::replace);
+            }
+            std::rename(TempPath.c_str(), Path.c_str());
+            Annotations = Merged;
+            Dirty = false;
+            return;
+        }
+    }
+} // namespace Utils
@@ -0,0 +1,86 @@
+#include "Utils/AnnotationScanner.hh"
+#include "Utils/TransformedDeclarationAnnotation.hh"
+
+#include "clang/Lex/Lexer.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include <algorithm>
+
+namespace Utils
+{
+    // Inverse of escape_json for the contents of a string literal
+    static std::string unescapeStringLiteral(llvm::StringRef Literal)
+    {
+        std::string Result;
+        auto Contents = Literal.drop_front().drop_back();
+        for (size_t i = 0; i < Contents.size(); i++)
+        {
+            if (Contents[i] == '\\' && i + 1 < Contents.size())
+            {
+                i++;
+            }
+            Result += Contents[i];
+        }
+        return Result;
+    }
+
+    std::vector<std::string> scanCpp2CAnnotations(
+        llvm::StringRef Buffer,
+        const clang::LangOptions &LO)
+    {
+        std::vector<std::string> Annotations;
+
+        // Most files don't contain any annotations, so skip lexing them
+        if (Buffer.find("CPP2C") == llvm::StringRef::npos)
+        {
+            return Annotations;
+        }
+
+        clang::Lexer L(clang::SourceLocation(), LO,
+                       Buffer.begin(), Buffer.begin(), Buffer.end());
+        clang::Token Tok;
+        // The two tokens before the current one, oldest first, so that
+        // annotate ( "..." can be matched once the string literal is lexed
+        clang::Token Prev[2];
+        Prev[0].startToken();
+        Prev[1].startToken();
+        while (!L.LexFromRawLexer(Tok))
+        {
+            if (Tok.is(clang::tok::string_literal) &&
+                Prev[1].is(clang::tok::l_paren) &&
+                Prev[0].is(clang::tok::raw_identifier) &&
+                Prev[0].getRawIdentifier() == "annotate")
+            {
+                auto Annotation = unescapeStringLiteral(
+                    llvm::StringRef(Tok.getLiteralData(), Tok.getLength()));
+                if (isCpp2CAnnotation(Annotation))
+                {
+                    Annotations.push_back(Annotation);
+                }
+            }
+            Prev[0] = Prev[1];
+            Prev[1] = Tok;
+        }
+        return Annotations;
+    }
+
+    std::vector<std::string> collectSourceFiles(const std::string &Dir)
+    {
+        std::vector<std::string> Files;
+        std::error_code EC;
+        for (llvm::sys::fs::recursive_directory_iterator it(Dir, EC), end;
+             it != end && !EC;
+             it.increment(EC))
+        {
+            auto Ext = llvm::sys::path::extension(it->path());
+            if ((Ext == ".c" || Ext == ".h") &&
+                it->type() != llvm::sys::fs::file_type::directory_file)
+            {
+                Files.push_back(it->path());
+            }
+        }
+        std::sort(Files.begin(), Files.end());
+        return Files;
+    }
+} // namespace Utils
@@ -0,0 +1,505 @@
+#include "Utils/EditList.hh"
+
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+#include <algorithm>
+
+namespace Utils
+{
+    EditList::EditList(clang::SourceManager &SM, const clang::LangOptions &LO)
+        : SM(SM), LO(LO) {}
+
+    bool EditList::insertTextBefore(
+        clang::SourceLocation Loc,
+        llvm::StringRef Text,
+        llvm::StringRef Key)
+    {
+        if (!Loc.isFileID())
+        {
+            return true;
+        }
+        auto Decomposed = SM.getDecomposedLoc(Loc);
+        Edits[Decomposed.first].push_back(
+            {Decomposed.second, 0, Text.str(), true, NextSequence++, Key.str()});
+        return false;
+    }
+
+    bool EditList::replaceText(
+        clang::SourceRange Range,
+        llvm::StringRef Text,
+        llvm::StringRef Key)
+    {
+        if (!Range.getBegin().isFileID() || !Range.getEnd().isFileID())
+        {
+            return true;
+        }
+        auto Begin = SM.getDecomposedLoc(Range.getBegin());
+        auto End = SM.getDecomposedLoc(Range.getEnd());
+        if (Begin.first != End.first || End.second < Begin.second)
+        {
+            return true;
+        }
+        unsigned EndOffset =
+            End.second + clang::Lexer::MeasureTokenLength(Range.getEnd(), SM, LO);
+        Edits[Begin.first].push_back(
+            {Begin.second, EndOffset - Begin.second, Text.str(), false, NextSequence++, Key.str()});
+        return false;
+    }
+
+    bool EditList::removeText(
+        clang::SourceLocation Begin,
+        clang::SourceLocation End,
+        llvm::StringRef Key)
+    {
+        if (!Begin.isFileID() || !End.isFileID())
+        {
+            return true;
+        }
+        auto B = SM.getDecomposedLoc(Begin);
+        auto E = SM.getDecomposedLoc(End);
+        if (B.first != E.first || E.second < B.second)
+        {
+            return true;
+        }
+        Edits[B.first].push_back(
+            {B.second, E.second - B.second, "", false, NextSequence++, Key.str()});
+        return false;
+    }
+
+    std::vector<clang::FileID> EditList::getEditedFiles() const
+    {
+        std::vector<clang::FileID> Files;
+        for (auto &&it : Edits)
+        {
+            Files.push_back(it.first);
+        }
+        return Files;
+    }
+
+    bool EditList::getMergedEdits(
+        clang::FileID FID,
+        std::vector<Edit> &Merged,
+        std::string &Err) const
+    {
+        Merged.clear();
+        auto it = Edits.find(FID);
+        if (it == Edits.end())
+        {
+            return true;
+        }
+
+        std::vector<Edit> Sorted = it->second;
+        std::sort(Sorted.begin(), Sorted.end(),
+                  [](const Edit &A, const Edit &B)
+                  {
+                      return A.Offset != B.Offset
+                                 ? A.Offset < B.Offset
+                                 : A.Sequence < B.Sequence;
+                  });
+
+        std::size_t i = 0;
+        while (i < Sorted.size())
+        {
+            // Merge all the edits at this offset.
+            // Text inserted before goes in front of everything inserted
+            // earlier, so those edits are placed in reverse order,
+            // followed by the rest in the order they were added
+            std::size_t j = i;
+            std::string Before, After;
+            unsigned Length = 0;
+            for (; j < Sorted.size() && Sorted[j].Offset == Sorted[i].Offset; j++)
+            {
+                if (Sorted[j].InsertBefore)
+                {
+                    Before.insert(0, Sorted[j].Text);
+                }
+                else
+                {
+                    After += Sorted[j].Text;
+                }
+                if (Sorted[j].Length != 0)
+                {
+                    if (Length != 0)
+                    {
+                        Err = "Overlapping edits at " + getFilePath(FID) +
+                              ":" + std::to_string(Sorted[i].Offset);
+                        return false;
+                    }
+                    Length = Sorted[j].Length;
+                }
+            }
+
+            if (!Merged.empty() &&
+                Merged.back().Offset + Merged.back().Length > Sorted[i].Offset)
+            {
+                Err = "Overlapping edits at " + getFilePath(FID) +
+                      ":" + std::to_string(Sorted[i].Offset);
+                return false;
+            }
+
+            Merged.push_back({Sorted[i].Offset, Length, Before + After,
+                              false, Sorted[i].Sequence, ""});
+            i = j;
+        }
+
+        return true;
+    }
+
+    bool EditList::validate(std::string &Err) const
+    {
+        std::vector<Edit> Merged;
+        for (auto &&it : Edits)
+        {
+            if (!getMergedEdits(it.first, Merged, Err))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string EditList::getRewrittenBuffer(clang::FileID FID) const
+    {
+        llvm::StringRef Original = SM.getBufferData(FID);
+
+        std::vector<Edit> Merged;
+        std::string Err;
+        bool Valid = getMergedEdits(FID, Merged, Err);
+        assert(Valid && "Overlapping edits");
+        (void)Valid;
+
+        std::string Result;
+        unsigned Pos = 0;
+        for (auto &&E : Merged)
+        {
+            Result += Original.slice(Pos, E.Offset).str();
+            Result += E.Text;
+            Pos = E.Offset + E.Length;
+        }
+        Result += Original.substr(Pos).str();
+        return Result;
+    }
+
+    bool EditList::overwriteFile(clang::FileID FID) const
+    {
+        const clang::FileEntry *FE = SM.getFileEntryForID(FID);
+        if (!FE)
+        {
+            return true;
+        }
+        std::string Path = FE->getName().str();
+        std::string TempPath = Path + ".cpp2c-tmp";
+        {
+            std::error_code EC;
+            llvm::raw_fd_ostream OS(TempPath, EC, llvm::sys::fs::OF_None);
+            if (EC)
+            {
+                return true;
+            }
+            OS << getRewrittenBuffer(FID);
+        }
+        if (llvm::sys::fs::rename(TempPath, Path))
+        {
+            llvm::sys::fs::remove(TempPath);
+            return true;
+        }
+        return false;
+    }
+
+    bool EditList::overwriteChangedFiles() const
+    {
+        bool Failed = false;
+        for (auto &&it : Edits)
+        {
+            Failed = overwriteFile(it.first) || Failed;
+        }
+        return Failed;
+    }
+
+    std::string EditList::getFilePath(clang::FileID FID) const
+    {
+        const clang::FileEntry *FE = SM.getFileEntryForID(FID);
+        if (!FE)
+        {
+            return "";
+        }
+        std::string RealPath = FE->tryGetRealPathName().str();
+        return RealPath != "" ? RealPath : FE->getName().str();
+    }
+
+    clang::tooling::Replacements EditList::toReplacements(clang::FileID FID) const
+    {
+        std::vector<Edit> Merged;
+        std::string Err;
+        bool Valid = getMergedEdits(FID, Merged, Err);
+        assert(Valid && "Overlapping edits");
+        (void)Valid;
+
+        // Edits are merged so that there is only one per offset,
+        // since Replacements rejects multiple insertions at the same offset
+        clang::tooling::Replacements Reps;
+        std::string Path = getFilePath(FID);
+        for (auto &&E : Merged)
+        {
+            if (auto AddErr = Reps.add(
+                    clang::tooling::Replacement(Path, E.Offset, E.Length, E.Text)))
+            {
+                llvm::errs() << llvm::toString(std::move(AddErr)) << '\n';
+                assert(false && "Failed to add replacement");
+            }
+        }
+        return Reps;
+    }
+
+    std::string EditList::toUnifiedDiff(clang::FileID FID) const
+    {
+        llvm::StringRef Original = SM.getBufferData(FID);
+
+        std::vector<Edit> Merged;
+        std::string Err;
+        bool Valid = getMergedEdits(FID, Merged, Err);
+        assert(Valid && "Overlapping edits");
+        (void)Valid;
+        if (Merged.empty())
+        {
+            return "";
+        }
+
+        // Offsets at which each line of the original file starts,
+        // plus the end of the file
+        std::vector<unsigned> LineStarts = {0};
+        for (unsigned i = 0; i < Original.size(); i++)
+        {
+            if (Original[i] == '\n' && i + 1 < Original.size())
+            {
+                LineStarts.push_back(i + 1);
+            }
+        }
+        unsigned NumLines = Original.empty() ? 0 : LineStarts.size();
+        LineStarts.push_back(Original.size());
+        auto lineOf = [&](unsigned Offset) -> unsigned
+        {
+            return std::upper_bound(LineStarts.begin(), LineStarts.begin() + NumLines, Offset) -
+                   LineStarts.begin() - 1;
+        };
+
+        auto originalLine = [&](unsigned Line)
+        {
+            return Original.slice(LineStarts[Line], LineStarts[Line + 1]);
+        };
+
+        // Regions of whole original lines [Begin, End) and the text
+        // that replaces them
+        struct Region
+        {
+            unsigned Begin, End;
+            std::string Text;
+        };
+        std::vector<Region> Regions;
+        for (auto &&E : Merged)
+        {
+            unsigned Begin = NumLines == 0 ? 0 : lineOf(E.Offset);
+            unsigned End;
+            if (NumLines == 0 ||
+                (E.Length == 0 && E.Offset == LineStarts[Begin] &&
+                 llvm::StringRef(E.Text).endswith("\n")))
+            {
+                // Whole lines inserted before a line
+                End = Begin;
+            }
+            else
+            {
+                End = lineOf(E.Offset + (E.Length ? E.Length - 1 : 0)) + 1;
+            }
+
+            if (!Regions.empty() && Begin < Regions.back().End)
+            {
+                // This edit touches the last line of the previous region,
+                // so extend that region instead
+                Region &R = Regions.back();
+                unsigned PrevEnd = R.End;
+                R.End = std::max(R.End, End);
+                std::string Tail = Original.slice(LineStarts[PrevEnd], LineStarts[R.End]).str();
+                R.Text += Tail;
+                // Apply the edit to the region's text by replacing the
+                // original text after it, which is still unedited
+                unsigned FromEnd = LineStarts[R.End] - E.Offset;
+                R.Text.replace(R.Text.size() - FromEnd, E.Length, E.Text);
+            }
+            else
+            {
+                std::string Text =
+                    End == Begin
+                        ? E.Text
+                        : Original.slice(LineStarts[Begin], E.Offset).str() +
+                              E.Text +
+                              Original.slice(E.Offset + E.Length, LineStarts[End]).str();
+                Regions.push_back({Begin, End, Text});
+            }
+
+            // If the edit removed the region's last newline, then the
+            // region's text runs into the next line, so the next line must
+            // be part of the region as well
+            Region &R = Regions.back();
+            while (!R.Text.empty() && R.Text.back() != '\n' && R.End < NumLines)
+            {
+                R.Text += originalLine(R.End).str();
+                R.End++;
+            }
+        }
+
+        auto splitLines = [](llvm::StringRef Text)
+        {
+            std::vector<llvm::StringRef> Lines;
+            while (!Text.empty())
+            {
+                auto Split = Text.split('\n');
+                Lines.push_back(Text.substr(0, Split.first.size() + (Split.first.size() < Text.size() ? 1 : 0)));
+                Text = Split.second;
+            }
+            return Lines;
+        };
+        auto emitLine = [](std::string &Out, char Prefix, llvm::StringRef Line)
+        {
+            Out += Prefix;
+            Out += Line.str();
+            if (!Line.endswith("\n"))
+            {
+                Out += "\n\\ No newline at end of file\n";
+            }
+        };
+
+        const unsigned Context = 3;
+        std::string Path = getFilePath(FID);
+        std::string Diff = "--- " + Path + "\n+++ " + Path + "\n";
+
+        // Difference between new and old line numbers before each hunk
+        int Delta = 0;
+        std::size_t i = 0;
+        while (i < Regions.size())
+        {
+            // Group regions whose context would overlap into one hunk
+            std::size_t j = i + 1;
+            while (j < Regions.size() &&
+                   Regions[j].Begin <= Regions[j - 1].End + 2 * Context)
+            {
+                j++;
+            }
+
+            unsigned HunkBegin = Regions[i].Begin > Context ? Regions[i].Begin - Context : 0;
+            unsigned HunkEnd = std::min(NumLines, Regions[j - 1].End + Context);
+
+            std::string Body;
+            unsigned OldCount = 0, NewCount = 0;
+            unsigned Line = HunkBegin;
+            for (std::size_t k = i; k < j; k++)
+            {
+                for (; Line < Regions[k].Begin; Line++, OldCount++, NewCount++)
+                {
+                    emitLine(Body, ' ', originalLine(Line));
+                }
+                for (; Line < Regions[k].End; Line++, OldCount++)
+                {
+                    emitLine(Body, '-', originalLine(Line));
+                }
+                for (auto &&NewLine : splitLines(Regions[k].Text))
+                {
+                    emitLine(Body, '+', NewLine);
+                    NewCount++;
+                }
+            }
+            for (; Line < HunkEnd; Line++, OldCount++, NewCount++)
+            {
+                emitLine(Body, ' ', originalLine(Line));
+            }
+
+            // Empty ranges are numbered by the line before them
+            unsigned OldStart = OldCount ? HunkBegin + 1 : HunkBegin;
+            unsigned NewStart = NewCount ? HunkBegin + Delta + 1 : HunkBegin + Delta;
+            Diff += "@@ -" + std::to_string(OldStart) + "," + std::to_string(OldCount) +
+                    " +" + std::to_string(NewStart) + "," + std::to_string(NewCount) +
+                    " @@\n" + Body;
+
+            Delta += (int)NewCount - (int)OldCount;
+            i = j;
+        }
+
+        return Diff;
+    }
+
+    nlohmann::json EditList::toJSON(clang::FileID FID) const
+    {
+        llvm::SHA1 Hasher;
+        Hasher.update(SM.getBufferData(FID));
+
+        nlohmann::json EditsJSON = nlohmann::json::array();
+        auto it = Edits.find(FID);
+        if (it != Edits.end())
+        {
+            for (auto &&E : it->second)
+            {
+                EditsJSON.push_back({{"offset", E.Offset},
+                                     {"length", E.Length},
+                                     {"text", E.Text},
+                                     {"insert before", E.InsertBefore},
+                                     {"key", E.Key}});
+            }
+        }
+
+        return {{"file", getFilePath(FID)},
+                {"sha1", llvm::toHex(Hasher.final(), true)},
+                {"edits", EditsJSON}};
+    }
+
+    bool EditList::overwriteMainFileAndRecordOthers(const std::string &Dir) const
+    {
+        // Only this TU edits its main file, so write that directly,
+        // but leave the other files for the merge step, since other TUs
+        // may be editing them at the same time
+        bool Failed = false;
+        nlohmann::json Record;
+        Record["main file"] = getFilePath(SM.getMainFileID());
+        Record["files"] = nlohmann::json::array();
+        for (auto &&FID : getEditedFiles())
+        {
+            if (FID == SM.getMainFileID())
+            {
+                Failed = overwriteFile(FID) || Failed;
+            }
+            else
+            {
+                Record["files"].push_back(toJSON(FID));
+            }
+        }
+
+        // Name the record after the main file, so that re-running
+        // this TU replaces its previous record
+        std::string Name = llvm::utohexstr(
+            llvm::xxHash64(Record["main file"].get<std::string>()));
+        llvm::SmallString<256> RecordPath(Dir);
+        llvm::sys::path::append(RecordPath, Name + ".json");
+        std::string TempPath = RecordPath.str().str() + ".tmp";
+        {
+            std::error_code EC;
+            llvm::raw_fd_ostream OS(TempPath, EC, llvm::sys::fs::OF_None);
+            if (EC)
+            {
+                return true;
+            }
+            OS << Record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        }
+        if (llvm::sys::fs::rename(TempPath, RecordPath))
+        {
+            llvm::sys::fs::remove(TempPath);
+            return true;
+        }
+        return Failed;
+    }
+} // namespace Utils
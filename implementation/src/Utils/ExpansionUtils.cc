@@ -6,7 +6,8 @@
 #include "clang/AST/ParentMapContext.h"
 #include "clang/Lex/Lexer.h"
 
-#include <chrono>
+#include <map>
+#include <mutex>
 
 namespace Utils
 {
@@ -25,7 +26,155 @@ namespace Utils
         return Expansion->getMI()->isObjectLike() &&
                !containsGlobalVars(E) &&
                !containsFunctionCalls(E) &&
-               getDesugaredCanonicalType(Ctx, ST).getAsString() != "void";
+               getDesugaredCanonicalType(Ctx, ST) != Ctx.VoidTy;
+    }
+
+    bool transformsToIntegerConstant(
+        MacroExpansionNode *Expansion,
+        ASTContext &Ctx)
+    {
+        auto E = dyn_cast_or_null<Expr>(*Expansion->getStmtsRef().begin());
+        assert(E != nullptr);
+        return transformsToVar(Expansion, Ctx) &&
+               E->getType()->isIntegerType() &&
+               E->isIntegerConstantExpr(Ctx);
+    }
+
+    bool transformsToEnumConstant(
+        MacroExpansionNode *Expansion,
+        ASTContext &Ctx)
+    {
+        // Enum constants have type int in C
+        return transformsToIntegerConstant(Expansion, Ctx) &&
+               getDesugaredCanonicalType(Ctx, *Expansion->getStmtsRef().begin()) == Ctx.IntTy;
+    }
+
+    string getParameterIndependentDefinitionText(
+        MacroExpansionNode *Expansion,
+        SourceManager &SM,
+        const LangOptions &LO)
+    {
+        auto MI = Expansion->getMI();
+        string Text = "";
+        for (auto &&Tok : MI->tokens())
+        {
+            if (!Text.empty())
+            {
+                Text += " ";
+            }
+            auto II = Tok.getIdentifierInfo();
+            int ParamNum = II ? MI->getParameterNum(II) : -1;
+            if (ParamNum >= 0)
+            {
+                // Identifiers may contain $, so a body that spells $0
+                // itself has the same text as one whose first parameter
+                // was replaced. That is safe, since definitions with the
+                // same text are only shared if their expressions' profiles
+                // match too (see profileExpansionWithoutArguments)
+                Text += "$" + to_string(ParamNum);
+            }
+            else
+            {
+                Text += Lexer::getSpelling(Tok, SM, LO);
+            }
+        }
+        return Text;
+    }
+
+    // Profiles S like Stmt::Profile, except that the subtrees in ArgIndices
+    // are profiled as their indices
+    static void profileStmtWithoutArguments(
+        ASTContext &Ctx,
+        const Stmt *S,
+        const map<const Stmt *, unsigned> &ArgIndices,
+        FoldingSetNodeID &ID)
+    {
+        if (!S)
+        {
+            ID.AddInteger(0);
+            return;
+        }
+
+        auto it = ArgIndices.find(S);
+        if (it != ArgIndices.end())
+        {
+            ID.AddInteger(1);
+            ID.AddInteger(it->second);
+            return;
+        }
+
+        // Leaves can't contain arguments, so profile them completely
+        if (S->child_begin() == S->child_end())
+        {
+            ID.AddInteger(2);
+            S->Profile(ID, Ctx, true);
+            return;
+        }
+
+        // Otherwise profile the parts of the node that are not its
+        // children, then its children
+        ID.AddInteger(3);
+        ID.AddInteger(S->getStmtClass());
+        if (auto E = dyn_cast<Expr>(S))
+        {
+            ID.AddPointer(E->getType().getCanonicalType().getAsOpaquePtr());
+        }
+        if (auto BO = dyn_cast<BinaryOperator>(S))
+        {
+            ID.AddInteger(BO->getOpcode());
+        }
+        else if (auto UO = dyn_cast<UnaryOperator>(S))
+        {
+            ID.AddInteger(UO->getOpcode());
+        }
+        else if (auto CE = dyn_cast<CastExpr>(S))
+        {
+            ID.AddInteger(CE->getCastKind());
+        }
+        else if (auto ME = dyn_cast<MemberExpr>(S))
+        {
+            ID.AddPointer(ME->getMemberDecl()->getCanonicalDecl());
+            ID.AddBoolean(ME->isArrow());
+        }
+        else if (auto UETT = dyn_cast<UnaryExprOrTypeTraitExpr>(S))
+        {
+            ID.AddInteger(UETT->getKind());
+        }
+        else if (auto DS = dyn_cast<DeclStmt>(S))
+        {
+            for (auto &&D : DS->decls())
+            {
+                ID.AddPointer(D->getCanonicalDecl());
+            }
+        }
+        for (auto &&Child : S->children())
+        {
+            profileStmtWithoutArguments(Ctx, Child, ArgIndices, ID);
+        }
+    }
+
+    void profileExpansionWithoutArguments(
+        ASTContext &Ctx,
+        MacroExpansionNode *Expansion,
+        FoldingSetNodeID &ID)
+    {
+        // An argument may be expanded several times, so map all the
+        // stmts it parses to to its index
+        map<const Stmt *, unsigned> ArgIndices;
+        unsigned i = 0;
+        for (auto &&Arg : Expansion->getArgumentsRef())
+        {
+            for (auto &&S : Arg.getStmtsRef())
+            {
+                ArgIndices.emplace(S, i);
+            }
+            i += 1;
+        }
+
+        for (auto &&S : Expansion->getStmtsRef())
+        {
+            profileStmtWithoutArguments(Ctx, S, ArgIndices, ID);
+        }
     }
 
     inline SourceLocation getStmtOrExprLocation(const Stmt &Node)
@@ -50,6 +199,10 @@ namespace Utils
         if (const auto E = dyn_cast_or_null<Expr>(ST))
         {
             QualType T = E->getType();
+            // Desugaring a qualified type may create new type nodes in the
+            // ASTContext, so serialize it for the parallel analysis phase
+            static std::mutex DesugarMutex;
+            std::lock_guard<std::mutex> Lock(DesugarMutex);
             return T.getDesugaredType(Ctx).getCanonicalType();
         }
         return QualType();
@@ -66,17 +219,21 @@ namespace Utils
         }
         if (Expansion->getMI()->isFunctionLike())
         {
-            for (auto &Arg : Expansion->getArguments())
+            for (auto &Arg : Expansion->getArgumentsRef())
             {
-                std::set<std::string> ArgTypes;
-                for (const auto *ST : Arg.getStmts())
+                if (Arg.getStmtsRef().empty())
                 {
-                    auto QT = getDesugaredCanonicalType(Ctx, ST);
-                    ArgTypes.insert('"' + QT.getAsString() + '"');
+                    return false;
                 }
-                if (ArgTypes.size() != 1)
+                // Canonical types are uniqued, so two types are the same
+                // exactly when their canonical QualTypes are identical
+                QualType FirstType = getDesugaredCanonicalType(Ctx, *Arg.getStmtsRef().begin());
+                for (const auto *ST : Arg.getStmtsRef())
                 {
-                    return false;
+                    if (getDesugaredCanonicalType(Ctx, ST) != FirstType)
+                    {
+                        return false;
+                    }
                 }
             }
         }
@@ -241,31 +398,53 @@ namespace Utils
         return true;
     }
 
-    void collectLValuesSpelledInRange(ASTContext &Ctx,
-                                      const Stmt *S,
-                                      SourceRangeCollection &Ranges,
-                                      set<const Stmt *> *LValuesFromArgs)
+    // Collects the L-values under S which are entirely spelled in the given
+    // ranges, and returns whether S itself is entirely spelled in them.
+    // Computing this bottom-up means each node is only visited once,
+    // instead of once per L-value above it
+    static bool collectLValuesSpelledInRangeImpl(ASTContext &Ctx,
+                                                 const Stmt *S,
+                                                 SourceRangeCollection &Ranges,
+                                                 set<const Stmt *> *LValuesFromArgs)
     {
         if (!S)
         {
-            return;
+            return true;
+        }
+
+        SourceLocation Loc = getStmtOrExprLocation(*S);
+        SourceLocation SpellingLoc = Ctx.getFullLoc(Loc).getSpellingLoc();
+        bool SpelledInRanges = Ranges.contains(SpellingLoc);
+
+        for (auto &&it : S->children())
+        {
+            // Always recurse so that L-values in every child are collected
+            if (!collectLValuesSpelledInRangeImpl(Ctx, it, Ranges, LValuesFromArgs))
+            {
+                SpelledInRanges = false;
+            }
         }
 
-        if (auto E = dyn_cast_or_null<Expr>(S))
+        if (SpelledInRanges)
         {
-            if (E->isLValue())
+            if (auto E = dyn_cast_or_null<Expr>(S))
             {
-                if (StmtAndSubStmtsSpelledInRanges(Ctx, S, Ranges))
+                if (E->isLValue())
                 {
                     LValuesFromArgs->insert(S);
                 }
             }
         }
 
-        for (auto &&it : S->children())
-        {
-            collectLValuesSpelledInRange(Ctx, it, Ranges, LValuesFromArgs);
-        }
+        return SpelledInRanges;
+    }
+
+    void collectLValuesSpelledInRange(ASTContext &Ctx,
+                                      const Stmt *S,
+                                      SourceRangeCollection &Ranges,
+                                      set<const Stmt *> *LValuesFromArgs)
+    {
+        collectLValuesSpelledInRangeImpl(Ctx, S, Ranges, LValuesFromArgs);
     }
 
     bool containsStmt(const Stmt *Haystack, const Stmt *Needle)
@@ -288,6 +467,41 @@ namespace Utils
         return false;
     }
 
+    void collectSubStmts(const Stmt *S,
+                         unordered_set<const Stmt *> &SubStmts)
+    {
+        if (!S)
+        {
+            return;
+        }
+        SubStmts.insert(S);
+        for (auto &&it : S->children())
+        {
+            collectSubStmts(it, SubStmts);
+        }
+    }
+
+    bool containsAnyStmt(const Stmt *Haystack,
+                         const unordered_set<const Stmt *> &Needles)
+    {
+        if (!Haystack)
+        {
+            return false;
+        }
+        if (Needles.find(Haystack) != Needles.end())
+        {
+            return true;
+        }
+        for (auto &&it : Haystack->children())
+        {
+            if (containsAnyStmt(it, Needles))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void collectStmtsThatChangeRValue(const Stmt *S,
                                       set<const Stmt *> *StmtsThatChangeRValue)
     {
@@ -571,56 +785,6 @@ namespace Utils
         return nullptr;
     }
 
-    string getUniqueNameForExpansionTransformation(
-        MacroExpansionNode *Expansion,
-        set<string> &UsedSymbols,
-        ASTContext &Ctx)
-    {
-        // Generate a unique name using a timetamp
-        auto t = std::chrono::system_clock::now();
-        string transformType = transformsToVar(Expansion, Ctx) ? "var" : "function";
-        string baseName = Expansion->getName() + "_" + std::to_string(t.time_since_epoch().count()) + transformType;
-        string uniqueName = baseName;
-        unsigned suffix = 0;
-        while (UsedSymbols.find(uniqueName) != UsedSymbols.end())
-        {
-            uniqueName = baseName + "_" + to_string(suffix);
-            suffix += 1;
-        }
-        return uniqueName;
-
-        /*
-
-        // TODO: Add a flag to optionally prepend the transformed name with
-        // the filepath. If we are only transforming a single compilation unit,
-        // we shouldn't need to prepend the function name with the path
-        // to the file the macro was expanded in. This would make
-        // the transformed definition name cleaner
-        string Filename =
-            SM.getFilename(Expansion->SpellingRange.getBegin()).str();
-
-        string transformType = TransformToVar ? "var" : "function";
-
-        // Remove non-alphanumeric characters from the filename
-        Filename.erase(remove_if(Filename.begin(), Filename.end(),
-                                 [](auto const &c) -> bool
-                                 { return !isalnum(c); }),
-                       Filename.end());
-
-        // Prepend the name with the name of the file that the macro was spelled
-        // in (with non-alphanumerics removed).
-        // We do this to ensure that transformation names are unique across files
-        // FIXME: This solution isn't perfect. Example: abc_1.c and abc1.c would
-        // both erase to abc1c. If both of these files contained an expansion
-        // of macro from a header that they both included, that macro would be
-        // transformed to a global var/function with the same name in each of them.
-        // We would then get new errors if we try to link these transformed files
-        // together.
-        return Filename + "_" + Expansion->Name + "_" + transformType;
-
-        */
-    }
-
     clang::QualType getPointeeType(clang::QualType T)
     {
         // Remove all pointers until we get down to the base type
@@ -23,6 +23,18 @@ namespace Utils
             return MacroName + ';' + MacroType + ';' + DefinitionFileRealPath + ';' + std::to_string(DefinitionNumber);
         }
 
+        std::string hashExpandedMacro(
+            const std::string MacroName,
+            const clang::MacroDefinition &MD,
+            clang::SourceManager &SM)
+        {
+            const clang::MacroInfo *MI = MD.getMacroInfo();
+            auto MacroType = MI->isObjectLike() ? "object-like" : "function-like";
+            std::string DefinitionFileRealPath =
+                Utils::fileRealPathOrEmpty(SM, MI->getDefinitionLoc());
+            return MacroName + ';' + MacroType + ';' + DefinitionFileRealPath + ';' + std::to_string(Utils::countMacroDefinitions(SM, MD));
+        }
+
         void emitUntransformedMessage(
             raw_fd_ostream &OS,
             ASTContext &Ctx,
@@ -50,6 +62,17 @@ namespace Utils
                << MD->getMacroInfo()->getDefinitionLoc().printToString(SM) << "\n";
         }
 
+        void emitRawMacroExpansionMessage(
+            raw_fd_ostream &OS,
+            const std::string &MacroHash,
+            SourceLocation SpellingLoc,
+            SourceManager &SM)
+        {
+            OS << "CPP2C:Raw Macro Expansion\t"
+               << MacroHash << "\t"
+               << SpellingLoc.printToString(SM) << "\n";
+        }
+
         void emitMacroExpansionMessage(
             raw_fd_ostream &OS,
             MacroExpansionNode *Expansion,
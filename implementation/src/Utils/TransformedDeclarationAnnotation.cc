@@ -108,4 +108,51 @@ namespace Utils
         return nlohmann::json::parse(JSONString);
     }
 
+    bool isCpp2CForwardDeclaration(const clang::Decl *D)
+    {
+        auto TD = clang::dyn_cast_or_null<clang::TagDecl>(D);
+        if (!TD || TD->isThisDeclarationADefinition())
+        {
+            return false;
+        }
+        for (auto &&A : TD->specific_attrs<clang::AnnotateAttr>())
+        {
+            if (A->getAnnotation() == "CPP2C")
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isCpp2CAnnotation(llvm::StringRef Annotation)
+    {
+        // The JSON keys are dumped in sorted order, so the marker key
+        // always comes first.
+        // Compact annotations are the marker followed by an ID
+        return Annotation == "CPP2C" ||
+               Annotation.startswith("CPP2C:") ||
+               Annotation.startswith("{\"emitted by CPP2C\"");
+    }
+
+    bool mayContainCpp2CAnnotations(const clang::SourceManager &SM)
+    {
+        // The files of a serialized AST or a PCH are only loaded when
+        // something needs them, so they may not be listed at all
+        if (SM.loaded_sloc_entry_size() != 0)
+        {
+            return true;
+        }
+        for (auto it = SM.fileinfo_begin(); it != SM.fileinfo_end(); ++it)
+        {
+            // Assume that a file whose buffer hasn't been loaded may
+            // contain annotations
+            auto Buffer = it->second->getRawBuffer();
+            if (!Buffer || Buffer->getBuffer().find("CPP2C") != llvm::StringRef::npos)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 } // namespace Utils
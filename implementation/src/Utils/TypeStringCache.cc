@@ -0,0 +1,15 @@
+#include "Utils/TypeStringCache.hh"
+
+namespace Utils
+{
+    std::string TypeStringCache::getAsString(clang::QualType QT)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        auto it = Strings.find(QT.getAsOpaquePtr());
+        if (it == Strings.end())
+        {
+            it = Strings.emplace(QT.getAsOpaquePtr(), QT.getAsString()).first;
+        }
+        return it->second;
+    }
+} // namespace Utils
@@ -0,0 +1,56 @@
+#include "Utils/UniqueNameGenerator.hh"
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+namespace Utils
+{
+    void UniqueNameGenerator::addUsedSymbol(const std::string &Symbol)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        UsedSymbols.insert(Symbol);
+    }
+
+    void UniqueNameGenerator::addUsedSymbols(const std::set<std::string> &Symbols)
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        UsedSymbols.insert(Symbols.begin(), Symbols.end());
+    }
+
+    bool UniqueNameGenerator::isUsed(const std::string &Symbol) const
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        return UsedSymbols.find(Symbol) != UsedSymbols.end();
+    }
+
+    std::string UniqueNameGenerator::getUniqueName(
+        const std::string &MacroName,
+        const std::string &MacroHash,
+        const std::string &Signature,
+        bool IsVar)
+    {
+        // xxHash64 doesn't depend on the process or platform,
+        // so the same transformation is always given the same base name
+        uint32_t Digest = static_cast<uint32_t>(
+            llvm::xxHash64(MacroHash + '\t' + Signature));
+        std::string Hex;
+        llvm::raw_string_ostream HexOS(Hex);
+        HexOS << llvm::format_hex_no_prefix(Digest, 8);
+        HexOS.flush();
+
+        std::string TransformType = IsVar ? "var" : "function";
+        std::string BaseName = MacroName + "_" + Hex + TransformType;
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        std::string UniqueName = BaseName;
+        unsigned Suffix = 0;
+        while (UsedSymbols.find(UniqueName) != UsedSymbols.end())
+        {
+            UniqueName = BaseName + "_" + std::to_string(Suffix);
+            Suffix += 1;
+        }
+        UsedSymbols.insert(UniqueName);
+        return UniqueName;
+    }
+} // namespace Utils
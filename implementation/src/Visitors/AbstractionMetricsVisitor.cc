@@ -0,0 +1,112 @@
+#include "Visitors/AbstractionMetricsVisitor.hh"
+
+#include <algorithm>
+
+namespace Visitors
+{
+    bool AbstractionMetricsVisitor::TraverseStmt(
+        clang::Stmt *S,
+        DataRecursionQueue *Queue)
+    {
+        if (!S)
+        {
+            return true;
+        }
+
+        // Children are traversed recursively rather than through the queue,
+        // so that each statement's depth is known once its traversal returns
+        bool IsExpr = clang::isa<clang::Expr>(S);
+        bool IsTopLevelExpr = IsExpr && ExpressionNesting == 0;
+        ExpressionNesting += IsExpr;
+        Depths.push_back(0);
+        bool Continue = RecursiveASTVisitor::TraverseStmt(S);
+        unsigned Depth = Depths.back();
+        Depths.pop_back();
+        ExpressionNesting -= IsExpr;
+
+        if (!Depths.empty())
+        {
+            Depths.back() = std::max(Depths.back(), Depth + 1);
+        }
+        if (IsTopLevelExpr)
+        {
+            if (ExpressionDepthCounts.size() <= Depth)
+            {
+                ExpressionDepthCounts.resize(Depth + 1);
+            }
+            ExpressionDepthCounts[Depth] += 1;
+        }
+        return Continue;
+    }
+
+    template <typename TraverseFn>
+    bool AbstractionMetricsVisitor::traverseTopLevelDecl(
+        clang::NamedDecl *D,
+        bool Collect,
+        TraverseFn Traverse)
+    {
+        if (!D->getLexicalDeclContext()->isTranslationUnit())
+        {
+            return Traverse();
+        }
+
+        auto Name = D->getNameAsString();
+        FunctionAndGlobalNames.insert(Name);
+        if (!Collect)
+        {
+            return Traverse();
+        }
+
+        // Later definitions of the same name replace earlier ones
+        auto &Symbols = UniqueSymbols[Name];
+        Symbols.clear();
+        auto SavedSymbols = CurrentSymbols;
+        CurrentSymbols = &Symbols;
+        bool Continue = Traverse();
+        CurrentSymbols = SavedSymbols;
+        return Continue;
+    }
+
+    bool AbstractionMetricsVisitor::TraverseFunctionDecl(clang::FunctionDecl *FD)
+    {
+        return traverseTopLevelDecl(
+            FD, FD->doesThisDeclarationHaveABody(),
+            [&]
+            { return RecursiveASTVisitor::TraverseFunctionDecl(FD); });
+    }
+
+    bool AbstractionMetricsVisitor::TraverseVarDecl(clang::VarDecl *VD)
+    {
+        return traverseTopLevelDecl(
+            VD, VD->hasInit(),
+            [&]
+            { return RecursiveASTVisitor::TraverseVarDecl(VD); });
+    }
+
+    bool AbstractionMetricsVisitor::VisitDeclRefExpr(clang::DeclRefExpr *DRE)
+    {
+        if (CurrentSymbols)
+        {
+            CurrentSymbols->insert(DRE->getNameInfo().getAsString());
+        }
+        return true;
+    }
+
+    const std::vector<unsigned> &
+    AbstractionMetricsVisitor::getExpressionDepthCounts() const
+    {
+        return ExpressionDepthCounts;
+    }
+
+    const std::set<std::string> &
+    AbstractionMetricsVisitor::getFunctionAndGlobalNames() const
+    {
+        return FunctionAndGlobalNames;
+    }
+
+    const std::map<std::string, std::set<std::string>> &
+    AbstractionMetricsVisitor::getUniqueSymbols() const
+    {
+        return UniqueSymbols;
+    }
+} // namespace Visitors
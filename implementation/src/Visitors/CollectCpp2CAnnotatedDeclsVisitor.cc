@@ -1,33 +1,34 @@
 #include "Visitors/CollectCpp2CAnnotatedDeclsVisitor.hh"
+#include "Utils/TransformedDeclarationAnnotation.hh"
 
 namespace Visitors
 {
     CollectCpp2CAnnotatedDeclsVisitor::CollectCpp2CAnnotatedDeclsVisitor(
         clang::ASTContext &Ctx) : Ctx(Ctx) {}
 
+    bool CollectCpp2CAnnotatedDeclsVisitor::TraverseTranslationUnitDecl(
+        clang::TranslationUnitDecl *TUD)
+    {
+        if (!Utils::mayContainCpp2CAnnotations(Ctx.getSourceManager()))
+        {
+            return true;
+        }
+        return RecursiveASTVisitor::TraverseTranslationUnitDecl(TUD);
+    }
+
     bool CollectCpp2CAnnotatedDeclsVisitor::VisitNamedDecl(clang::NamedDecl *D)
     {
+        if (!D->hasAttrs())
+        {
+            return true;
+        }
 
-        auto PP = Ctx.getPrintingPolicy();
-        for (auto &&it : D->attrs())
+        for (auto &&A : D->specific_attrs<clang::AnnotateAttr>())
         {
-            if (auto attrName = it->getAttrName())
+            if (Utils::isCpp2CAnnotation(A->getAnnotation()))
             {
-                std::string attrNameStr = attrName->getName().str();
-                if (attrNameStr == "annotate")
-                {
-                    std::string SS;
-                    llvm::raw_string_ostream S(SS);
-                    it->printPretty(S, PP);
-                    std::string annotation = S.str();
-                    // All the annotations we emit contain the substring
-                    // "CPP2C".
-                    // Hopefully this is not a common substring in other annotations?
-                    if (annotation.find("CPP2C") != std::string::npos)
-                    {
-                        Decls.push_back(D);
-                    }
-                }
+                Decls.push_back(D);
+                break;
             }
         }
         return true;
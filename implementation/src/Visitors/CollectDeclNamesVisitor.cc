@@ -26,4 +26,10 @@ namespace Visitors
         VarNames->insert(VarName);
         return true;
     }
+
+    bool CollectDeclNamesVisitor::VisitEnumConstantDecl(EnumConstantDecl *ECD)
+    {
+        VarNames->insert(ECD->getName().str());
+        return true;
+    }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "clang/Basic/SourceManager.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace Visitors
@@ -10,20 +11,26 @@ namespace Visitors
     DeclRangeVisitor::DeclRangeVisitor(clang::ASTContext &Ctx) :
         Ctx(Ctx) {}
 
-    bool DeclRangeVisitor::VisitDecl(clang::Decl *D)
+    bool DeclRangeVisitor::TraverseDecl(clang::Decl *D)
     {
         if (!D)
         {
             return true;
         }
 
-        // Don't include the Translation Unit Decl
+        // Don't include the Translation Unit Decl, but do traverse
+        // its direct children
         if (clang::isa<clang::TranslationUnitDecl>(D))
         {
-            return true;
+            return clang::RecursiveASTVisitor<DeclRangeVisitor>::TraverseDecl(D);
         }
 
-        this->DeclRanges.push_back(D->getSourceRange());
+        // Implicit decls (e.g., builtin typedefs) have no range
+        if (D->getSourceRange().isValid())
+        {
+            this->DeclRanges.push_back(D->getSourceRange());
+            Sorted = false;
+        }
 
         return true;
     }
@@ -33,4 +40,61 @@ namespace Visitors
     {
         return this->DeclRanges;
     }
+
+    void DeclRangeVisitor::sortDeclRanges()
+    {
+        std::sort(DeclRanges.begin(), DeclRanges.end(),
+                  [](const clang::SourceRange &A, const clang::SourceRange &B)
+                  {
+                      return A.getBegin() < B.getBegin();
+                  });
+
+        MaxEndIndices.clear();
+        MaxEndIndices.reserve(DeclRanges.size());
+        for (std::size_t i = 0; i < DeclRanges.size(); i++)
+        {
+            if (i == 0 ||
+                DeclRanges[MaxEndIndices.back()].getEnd() < DeclRanges[i].getEnd())
+            {
+                MaxEndIndices.push_back(i);
+            }
+            else
+            {
+                MaxEndIndices.push_back(MaxEndIndices.back());
+            }
+        }
+
+        Sorted = true;
+    }
+
+    const clang::SourceRange *DeclRangeVisitor::findDeclRangeContaining(
+        clang::SourceLocation Loc)
+    {
+        if (!Sorted)
+        {
+            sortDeclRanges();
+        }
+
+        // Find the first range which begins after Loc; only the ranges
+        // before it can contain Loc
+        auto it = std::upper_bound(
+            DeclRanges.begin(), DeclRanges.end(), Loc,
+            [](const clang::SourceLocation &L, const clang::SourceRange &R)
+            {
+                return L < R.getBegin();
+            });
+        if (it == DeclRanges.begin())
+        {
+            return nullptr;
+        }
+
+        // Of those ranges, the one that ends last contains Loc if any does
+        std::size_t Last = std::distance(DeclRanges.begin(), it) - 1;
+        const clang::SourceRange &Candidate = DeclRanges[MaxEndIndices[Last]];
+        if (Loc <= Candidate.getEnd())
+        {
+            return &Candidate;
+        }
+        return nullptr;
+    }
 } // namespace Visitors
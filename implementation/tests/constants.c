@@ -0,0 +1,45 @@
+// tests transforming macros that expand to integer constant expressions,
+// which --constants emits as static const variables or enum constants
+
+#include <stdio.h>
+
+struct pair
+{
+    int a;
+    int b;
+};
+
+#define SIZE 4
+#define MASK 0xffUL
+#define HALF_PAIR (sizeof(struct pair) / 2)
+
+int main()
+{
+    int n = 4;
+
+    printf("%d\n",
+        // Should transform
+        SIZE
+    );
+
+    printf("%lu\n",
+        // Should transform
+        MASK
+    );
+
+    printf("%d\n",
+        // Should transform
+        (int)HALF_PAIR
+    );
+
+    switch (n)
+    {
+    // Only transformed by --constants=enum, since case labels must be
+    // constant expressions
+    case SIZE:
+        printf("four\n");
+        break;
+    }
+
+    return 0;
+}
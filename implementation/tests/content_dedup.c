@@ -0,0 +1,53 @@
+// tests transforming macros whose definitions are the same up to the names
+// of their parameters, which -cdd transforms to a single definition as long
+// as their signatures and the code they expand to are the same too
+
+#include <stdio.h>
+
+#define ADD(a, b) ((a) + (b))
+#define PLUS(x, y) ((x) + (y))
+
+// The same definition, but SCALE expands to a different constant in each
+#define SCALE 2
+#define TWICE(a) ((a) * SCALE)
+
+int twice(int a)
+{
+    return
+        // Should transform
+        TWICE(a);
+}
+
+#undef SCALE
+#define SCALE 3
+#define THRICE(a) ((a) * SCALE)
+
+int thrice(int a)
+{
+    return
+        // Should transform
+        THRICE(a);
+}
+
+int main()
+{
+    printf("%d\n",
+        // Should transform
+        ADD(1, 2)
+    );
+
+    printf("%d\n",
+        // Should transform
+        PLUS(3, 4)
+    );
+
+    // The same definition as the others, but with a different signature
+    printf("%f\n",
+        // Should transform
+        PLUS(1.5, 2.5)
+    );
+
+    printf("%d %d\n", twice(5), thrice(5));
+
+    return 0;
+}
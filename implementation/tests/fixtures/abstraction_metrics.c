@@ -0,0 +1,14 @@
+// tests the abstraction metrics of a file. The depth of an expression
+// counts only the expressions nested in it, including implicit casts
+
+int g = 1;
+
+int add(int a, int b)
+{
+    return a + b;
+}
+
+int main(void)
+{
+    return add(g, 2);
+}
@@ -0,0 +1,25 @@
+// tests emitting the edits of a transformation as a patch and as
+// replacements. The declarations are emitted at the very start of the
+// file, and the last expansion is on its last line, which has no newline
+
+#define ONE 1
+#define ADD(a, b) ((a) + (b))
+
+int f(void)
+{
+    // Edits on adjacent lines, whose hunks merge
+    int x = ONE;
+    int y = ADD(x, ONE);
+    return y;
+}
+
+// Lines which separate the hunks of the edits before and after them
+int h1(void) { return 1; }
+int h2(void) { return 2; }
+int h3(void) { return 3; }
+int h4(void) { return 4; }
+int h5(void) { return 5; }
+int h6(void) { return 6; }
+int h7(void) { return 7; }
+
+int g(void) { return ADD(ONE, 2); }
\ No newline at end of file
@@ -0,0 +1,14 @@
+// tests removing annotations. Only the header has annotations that were
+// emitted by cpp2c, so the main file must not be changed
+
+#include "remove_annotations.h"
+
+// Annotations of other tools, including one that the definition inherits
+int helper(void) __attribute__((annotate("other tool")));
+int helper(void) { return 1; }
+static int counter __attribute__((annotate("other tool"), unused)) = 2;
+
+int main(void)
+{
+    return helper() - 1;
+}
@@ -0,0 +1,2 @@
+// A forward declaration that a previous transformation emitted to a header
+struct __attribute__((annotate("CPP2C"))) point;
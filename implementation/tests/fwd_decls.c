@@ -0,0 +1,28 @@
+// tests that a tag type used by several transformed signatures is only
+// forward declared once in the file the macros are defined in
+
+#include "fwd_decls.h"
+
+#include <stdio.h>
+
+int main()
+{
+    struct point p = {1, 2};
+
+    printf("%d\n",
+        // Should transform
+        GET_X(&p)
+    );
+
+    printf("%d\n",
+        // Should transform
+        GET_Y(&p)
+    );
+
+    printf("%d\n",
+        // Should transform
+        GET_SUM(&p)
+    );
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+// The macros whose transformations need struct point to be forward
+// declared in this file
+
+struct point
+{
+    int x;
+    int y;
+};
+
+#define GET_X(p) ((p)->x)
+#define GET_Y(p) ((p)->y)
+// Its transformed definition expands GET_X and GET_Y, which are only
+// transformed by a second run
+#define GET_SUM(p) (GET_X(p) + GET_Y(p))
@@ -0,0 +1,35 @@
+#!/bin/bash
+# tests that am prints the expected metrics for a small file, and the same
+# metrics for its serialized AST
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+command -v python3 > /dev/null || exit 77
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/fixtures/abstraction_metrics.c" "$TMP"
+cd "$TMP"
+
+"$CPP2C" am abstraction_metrics.c > from_source.json
+"$CLANG" -emit-ast -o abstraction_metrics.ast abstraction_metrics.c
+"$CPP2C" am abstraction_metrics.ast > from_ast.json
+
+python3 - "$TESTS_DIR/fixtures/abstraction_metrics.expected" from_source.json from_ast.json <<'PY'
+import json
+import sys
+
+with open(sys.argv[1]) as fp:
+    expected = json.load(fp)
+for path in sys.argv[2:]:
+    with open(path) as fp:
+        metrics = json.load(fp)
+    main_file = metrics.pop('main file')
+    if path == 'from_source.json' and not main_file.endswith('/abstraction_metrics.c'):
+        print(f'unexpected main file: {main_file}')
+        sys.exit(1)
+    if metrics != expected:
+        print(f'{path}: expected {expected}, got {metrics}')
+        sys.exit(1)
+PY
@@ -0,0 +1,49 @@
+#!/bin/bash
+# tests that --constants emits integer constant macros as static const
+# variables or as enum constants, and that the transformed program behaves
+# the same as the original
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/constants.c" "$TMP"
+cd "$TMP"
+
+"$CLANG" -o original constants.c
+./original > expected.txt
+
+# Compiles and runs the given transformed file, and checks its output
+check_runs_the_same() {
+    "$CLANG" -Wno-attributes -o transformed "$1"
+    ./transformed > actual.txt
+    cmp expected.txt actual.txt
+}
+
+"$CPP2C" tr --constants=const constants.c > const.c
+grep -q 'static const int' const.c
+grep -q 'static const unsigned long' const.c
+if grep -q 'enum {' const.c; then
+    echo "--constants=const emitted an enum constant"
+    exit 1
+fi
+grep -q 'case SIZE:' const.c
+check_runs_the_same const.c
+
+# SIZE has type int, so it becomes an enum constant, which may also replace
+# the expansion in the case label. MASK does not, so it stays a static
+# const variable
+"$CPP2C" tr --constants=enum constants.c > enum.c
+grep -q 'enum {' enum.c
+grep -q 'static const unsigned long' enum.c
+if grep -q 'case SIZE:' enum.c; then
+    echo "--constants=enum did not transform the case label"
+    exit 1
+fi
+check_runs_the_same enum.c
+
+# Checking properties in parallel must not change the output
+"$CPP2C" tr --constants=enum --jobs=4 constants.c > enum_parallel.c
+cmp enum.c enum_parallel.c
@@ -0,0 +1,33 @@
+#!/bin/bash
+# tests that -cdd shares transformed definitions between macros only if
+# their definitions, signatures, and the code they expand to are the same
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/content_dedup.c" "$TMP"
+cd "$TMP"
+
+"$CLANG" -o original content_dedup.c
+./original > expected.txt
+
+# Each transformed definition has one annotated declaration
+count_declarations() {
+    grep -c '__attribute__((annotate(' "$1" || true
+}
+
+"$CPP2C" tr content_dedup.c > separate.c
+"$CPP2C" tr -cdd content_dedup.c > shared.c
+
+# Only ADD(1, 2) and PLUS(3, 4) share a definition. PLUS(1.5, 2.5) has a
+# different signature, and THRICE's definition differs from TWICE's once
+# SCALE is expanded
+test "$(count_declarations separate.c)" -eq 5
+test "$(count_declarations shared.c)" -eq 4
+
+"$CLANG" -Wno-attributes -o transformed shared.c
+./transformed > actual.txt
+cmp expected.txt actual.txt
@@ -0,0 +1,36 @@
+#!/bin/bash
+# tests that count prints the same macro definition and raw expansion
+# messages as tr -v for each test file, since the evaluation counts macros
+# with count instead of tr
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR"/*.c "$TESTS_DIR"/*.h "$TMP"
+cd "$TMP"
+
+# tr emits other messages too, and the two commands may emit these in
+# different orders
+count_messages() {
+    grep -E '^CPP2C:(Macro Definition|Raw Macro Expansion)'$'\t' "$1" | sort || true
+}
+
+failed=0
+for file in *.c; do
+    "$CPP2C" tr -v "$file" > /dev/null 2> "$file.tr.err"
+    "$CPP2C" count "$file" > /dev/null 2> "$file.count.err"
+    if ! diff <(count_messages "$file.tr.err") <(count_messages "$file.count.err"); then
+        echo "count and tr -v emitted different messages for $file"
+        failed=1
+    fi
+done
+
+# Make sure that there were messages to compare
+if ! cat *.tr.err | grep -q '^CPP2C:Raw Macro Expansion'; then
+    echo "tr -v emitted no raw expansion messages"
+    exit 1
+fi
+exit $failed
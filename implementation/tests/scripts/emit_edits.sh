@@ -0,0 +1,37 @@
+#!/bin/bash
+# tests that the patch and the replacements that cpp2c emits make the same
+# edits as transforming the file does
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/fixtures/emit_edits.c" "$TMP"
+cd "$TMP"
+
+"$CPP2C" tr emit_edits.c > expected.c
+if cmp -s emit_edits.c expected.c; then
+    echo "Nothing was transformed"
+    exit 1
+fi
+
+# The patch must apply without fuzz, and have separate hunks for the edits
+# at the start and at the end of the file
+"$CPP2C" tr --emit=patch emit_edits.c > edits.patch
+patch --dry-run -F0 emit_edits.c < edits.patch
+patch -F0 -o patched.c emit_edits.c < edits.patch
+cmp patched.c expected.c
+grep -q '^@@ -1,' edits.patch
+test "$(grep -c '^@@' edits.patch)" -ge 2
+grep -q '^\\ No newline at end of file' edits.patch
+
+if [[ -z $CLANG_APPLY_REPLACEMENTS || ! -x $CLANG_APPLY_REPLACEMENTS ]]; then
+    echo "clang-apply-replacements not found"
+    exit 77
+fi
+mkdir replacements
+"$CPP2C" tr --emit=replacements emit_edits.c > replacements/emit_edits.yaml
+"$CLANG_APPLY_REPLACEMENTS" replacements
+cmp emit_edits.c expected.c
@@ -0,0 +1,59 @@
+#!/bin/bash
+# tests that -fp transforms a file with macros nested in a header's macros
+# to the same fixed point as running tr -i until nothing changes, and
+# writes the rewritten header too
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP"
+
+# Annotations record the files' real paths, so every run transforms the
+# same copies
+restore() {
+    cp "$TESTS_DIR/fwd_decls.c" "$TESTS_DIR/fwd_decls.h" .
+}
+
+# Transform in place until a run changes nothing
+restore
+Runs=0
+while true; do
+    cat fwd_decls.c fwd_decls.h > before.txt
+    "$CPP2C" tr -i fwd_decls.c
+    cat fwd_decls.c fwd_decls.h > after.txt
+    if cmp -s before.txt after.txt; then
+        break
+    fi
+    Runs=$((Runs + 1))
+    if [ "$Runs" -gt 10 ]; then
+        echo "tr -i did not reach a fixed point"
+        exit 1
+    fi
+done
+# The nested expansions need more than one run
+test "$Runs" -gt 1
+cp fwd_decls.c repeated.c
+cp fwd_decls.h repeated.h
+
+restore
+"$CPP2C" tr -i -fp fwd_decls.c
+cmp repeated.c fwd_decls.c
+cmp repeated.h fwd_decls.h
+if cmp -s fwd_decls.h "$TESTS_DIR/fwd_decls.h"; then
+    echo "-fp did not write the rewritten header"
+    exit 1
+fi
+if ls ./*.cpp2c-tmp > /dev/null 2>&1; then
+    echo "-fp left temporary files behind"
+    exit 1
+fi
+"$CLANG" -fsyntax-only -Wno-attributes fwd_decls.c
+
+# Printing the fixed point prints the same main file, and writes nothing
+restore
+"$CPP2C" tr -fp fwd_decls.c > printed.c
+cmp printed.c repeated.c
+cmp fwd_decls.h "$TESTS_DIR/fwd_decls.h"
@@ -0,0 +1,31 @@
+#!/bin/bash
+# tests that transforming a file again does not forward declare the tag
+# types which the previous run already forward declared
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/fwd_decls.c" "$TESTS_DIR/fwd_decls.h" "$TMP"
+cd "$TMP"
+
+count_fwd_decls() {
+    grep -cE 'annotate\("CPP2C"\)\)\) +point;' fwd_decls.h || true
+}
+
+# The first run transforms GET_X, GET_Y, and GET_SUM
+"$CPP2C" tr -i fwd_decls.c
+test "$(count_fwd_decls)" -eq 1
+cp fwd_decls.c first_run.c
+
+# The second run transforms the expansions in GET_SUM's transformed
+# definition, whose declarations go after the existing forward declaration
+"$CPP2C" tr -i fwd_decls.c
+if cmp -s fwd_decls.c first_run.c; then
+    echo "The second run transformed nothing"
+    exit 1
+fi
+test "$(count_fwd_decls)" -eq 1
+"$CLANG" -fsyntax-only -Wno-attributes fwd_decls.c
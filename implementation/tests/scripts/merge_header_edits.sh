@@ -0,0 +1,82 @@
+#!/bin/bash
+# tests that merging the header edits that translation units record with
+# --header-edits gives the same headers as transforming the translation
+# units one after another, and that conflicting edits are rejected
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+command -v python3 > /dev/null || exit 77
+MERGE="$TESTS_DIR/../../evaluation/merge_header_edits.py"
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP"
+
+# Annotations record the files' real paths, so every run transforms the
+# same copies. a.c and b.c include the same header
+restore() {
+    rm -rf edits
+    mkdir edits
+    cp "$TESTS_DIR/fwd_decls.h" .
+    cp "$TESTS_DIR/fwd_decls.c" a.c
+    cp "$TESTS_DIR/fwd_decls.c" b.c
+}
+
+# A single translation unit
+restore
+"$CPP2C" tr -i a.c
+cp a.c expected_a.c
+cp fwd_decls.h expected.h
+restore
+"$CPP2C" tr -i --header-edits=edits a.c
+cmp fwd_decls.h "$TESTS_DIR/fwd_decls.h"
+python3 "$MERGE" edits
+cmp a.c expected_a.c
+cmp fwd_decls.h expected.h
+
+# Two translation units that make the same edits to the header, except
+# for the realpaths in the annotations, which are unioned
+restore
+"$CPP2C" tr -i a.c
+"$CPP2C" tr -i b.c
+cp b.c expected_b.c
+cp fwd_decls.h expected.h
+grep -q 'b\.c' expected.h
+restore
+"$CPP2C" tr -i --header-edits=edits a.c
+"$CPP2C" tr -i --header-edits=edits b.c
+python3 "$MERGE" edits
+cmp a.c expected_a.c
+cmp b.c expected_b.c
+cmp fwd_decls.h expected.h
+# The records are removed once applied
+test -z "$(ls edits)"
+
+# Two records that make different edits with the same key conflict
+restore
+python3 - fwd_decls.h edits <<'EOF'
+import hashlib
+import json
+import os
+import sys
+
+header, edits_dir = sys.argv[1:]
+with open(header, 'rb') as fp:
+    sha1 = hashlib.sha1(fp.read()).hexdigest()
+for name, text in [('a', 'int a;\n'), ('b', 'int b;\n')]:
+    record = {'main file': os.path.realpath(name + '.c'),
+              'files': [{'file': os.path.realpath(header),
+                         'sha1': sha1,
+                         'edits': [{'offset': 0, 'length': 0, 'text': text,
+                                    'insert before': False,
+                                    'key': 'declaration'}]}]}
+    with open(os.path.join(edits_dir, name + '.json'), 'w') as fp:
+        json.dump(record, fp)
+EOF
+if python3 "$MERGE" edits 2> error.txt; then
+    echo "Conflicting edits were merged"
+    exit 1
+fi
+grep -q 'Conflicting edits' error.txt
+cmp fwd_decls.h "$TESTS_DIR/fwd_decls.h"
@@ -0,0 +1,23 @@
+#!/bin/bash
+# tests that pa finds the same annotations in a serialized AST as in the
+# source file it was emitted from
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/nested_macros.c" "$TMP"
+cd "$TMP"
+
+"$CPP2C" tr -i nested_macros.c
+"$CPP2C" pa nested_macros.c > from_source.txt
+if ! grep -q 'emitted by CPP2C' from_source.txt; then
+    echo "pa found no annotations in the transformed file"
+    exit 1
+fi
+
+"$CLANG" -Wno-attributes -emit-ast -o nested_macros.ast nested_macros.c
+"$CPP2C" pa nested_macros.ast > from_ast.txt
+cmp from_source.txt from_ast.txt
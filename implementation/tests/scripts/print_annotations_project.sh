@@ -0,0 +1,74 @@
+#!/bin/bash
+# tests that pa --project finds the same annotations as parsing each
+# translation unit, and prints each annotation once, with the files its
+# definitions were emitted to merged, even when two translation units
+# annotated the same header
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+command -v python3 > /dev/null || exit 77
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+# The quote in the directory's name ends up in the annotations' paths, so
+# their string literals contain escaped quotes inside escaped quotes
+Dir="$TMP/pro\"ject"
+mkdir "$Dir"
+cp "$TESTS_DIR/fwd_decls.h" "$Dir"
+cp "$TESTS_DIR/fwd_decls.c" "$Dir/a.c"
+cp "$TESTS_DIR/fwd_decls.c" "$Dir/b.c"
+cd "$Dir"
+
+"$CPP2C" tr -i a.c
+"$CPP2C" tr -i b.c
+"$CPP2C" pa a.c > "$TMP/a.json"
+"$CPP2C" pa b.c > "$TMP/b.json"
+"$CPP2C" pa --project=. > "$TMP/project.json" 2> "$TMP/errors.txt"
+if [ -s "$TMP/errors.txt" ]; then
+    cat "$TMP/errors.txt"
+    exit 1
+fi
+
+python3 - "$TMP/project.json" "$TMP/a.json" "$TMP/b.json" <<'EOF'
+import json
+import sys
+
+PATHS = 'transformed definition realpaths'
+
+
+def key(annotation):
+    return tuple(sorted((k, json.dumps(v)) for k, v in annotation.items()
+                        if k != PATHS))
+
+
+with open(sys.argv[1]) as fp:
+    project = json.load(fp)
+merged = {}
+for path in sys.argv[2:]:
+    with open(path) as fp:
+        for annotation in json.load(fp):
+            merged.setdefault(key(annotation), set()).update(annotation[PATHS])
+
+if not project:
+    print('pa --project found no annotations')
+    sys.exit(1)
+printed = {}
+for annotation in project:
+    if key(annotation) in printed:
+        print(f'printed more than once: {annotation}')
+        sys.exit(1)
+    printed[key(annotation)] = set(annotation[PATHS])
+if printed != merged:
+    print(f'expected {merged}, printed {printed}')
+    sys.exit(1)
+# The header's annotations list the definitions of both files
+if not any(any(p.endswith('/a.c') for p in paths) and
+           any(p.endswith('/b.c') for p in paths)
+           for paths in printed.values()):
+    print('no annotation lists the definitions of both files')
+    sys.exit(1)
+if not all('"' in a['macro definition realpath'] for a in project):
+    print('the quotes in the paths were not unescaped')
+    sys.exit(1)
+EOF
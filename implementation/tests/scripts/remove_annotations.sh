@@ -0,0 +1,48 @@
+#!/bin/bash
+# tests that ra removes only the annotations emitted by cpp2c, and leaves
+# the annotations of other tools as they were written
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/fixtures/remove_annotations.c" "$TESTS_DIR/fixtures/remove_annotations.h" \
+    "$TESTS_DIR/nested_macros.c" "$TMP"
+cd "$TMP"
+cp remove_annotations.c original.c
+
+# Only the header changes, so nothing is printed for the main file
+"$CPP2C" ra remove_annotations.c > printed.c
+if [ -s printed.c ]; then
+    echo "ra printed the main file, which it did not change"
+    exit 1
+fi
+
+"$CPP2C" ra -i remove_annotations.c
+cmp remove_annotations.c original.c
+if grep -q 'CPP2C' remove_annotations.h; then
+    echo "ra left an annotation in the header"
+    exit 1
+fi
+grep -q 'struct point;' remove_annotations.h
+"$CLANG" -fsyntax-only -Wno-attributes remove_annotations.c
+
+# Annotations that tr emitted to the main file are removed from the
+# printed file
+"$CPP2C" tr -i nested_macros.c
+grep -q 'CPP2C' nested_macros.c
+"$CPP2C" ra nested_macros.c > removed.c
+if grep -q 'CPP2C' removed.c; then
+    echo "ra left an annotation in the main file"
+    exit 1
+fi
+"$CLANG" -fsyntax-only removed.c
+
+# Failing to write the removals fails the command
+cp original.c remove_annotations.c
+if "$CPP2C" ra -i --header-edits=missing_dir remove_annotations.c 2> /dev/null; then
+    echo "ra succeeded without writing its record of the header's edits"
+    exit 1
+fi
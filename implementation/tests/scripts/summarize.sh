@@ -0,0 +1,37 @@
+#!/bin/bash
+# tests that cpp2c-summarize computes the expected statistics from a fixed
+# set of event records, whether it reads them directly or from shards, and
+# that it fails if Clang crashed on any translation unit
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+SUMMARIZE="$(dirname "$CPP2C")/cpp2c-summarize"
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP"
+
+EVENTS="$TESTS_DIR/fixtures/summarize_events.txt"
+EXPECTED="$TESTS_DIR/fixtures/summarize_events.expected"
+
+"$SUMMARIZE" "$EVENTS" > summary.txt
+diff -u "$EXPECTED" summary.txt
+
+# The count records and each run's records, summarized separately and
+# merged
+awk -v Dir="$TMP" '/^CPP2C:Translation Unit\t/ { Part += 1 } { print > (Dir "/part" Part ".txt") }' "$EVENTS"
+for Part in part*.txt; do
+    "$SUMMARIZE" --shard="$Part.json" "$Part"
+done
+"$SUMMARIZE" part*.txt.json > merged.txt
+diff -u "$EXPECTED" merged.txt
+
+# A crash is reported, and the command fails
+cp "$EVENTS" crashed.txt
+printf 'CPP2C:Translation Unit\ttransform\t2\t/src/b.c\t0.5\nPLEASE submit a bug report\n' >> crashed.txt
+if "$SUMMARIZE" crashed.txt > /dev/null 2> error.txt; then
+    echo "cpp2c-summarize succeeded although Clang crashed"
+    exit 1
+fi
+grep -q 'crashed on 1 translation units' error.txt
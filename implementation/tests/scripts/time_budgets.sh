@@ -0,0 +1,50 @@
+#!/bin/bash
+# tests that expansions that run out of time are reported as untransformed,
+# that a translation unit that runs out of time is left as it was, and that
+# budgets which don't run out don't change the output
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR/nested_macros.c" "$TMP"
+cd "$TMP"
+cp nested_macros.c original.c
+
+"$CPP2C" tr nested_macros.c > unbudgeted.c
+
+# Budgets that don't run out change nothing
+"$CPP2C" tr --expansion-budget=100000 --tu-budget=100000 nested_macros.c > budgeted.c
+cmp unbudgeted.c budgeted.c
+
+# A budget of 0 has run out before the file is parsed, so every expansion
+# runs out of time
+"$CPP2C" tr -v --tu-budget=0 nested_macros.c > printed.c 2> messages.txt
+cmp printed.c original.c
+if ! grep -qE '^CPP2C:Untransformed Expansion'$'\t''.*'$'\t''Time budget exceeded'$'\t' messages.txt; then
+    echo "no expansion was reported as exceeding the budget"
+    exit 1
+fi
+if grep -q '^CPP2C:Transformed Expansion' messages.txt; then
+    echo "an expansion was reported as transformed after the budget ran out"
+    exit 1
+fi
+
+# Nothing is written once the budget has run out, not even the verdict
+# cache or the annotation manifest
+for Mode in "" "-fp"; do
+    "$CPP2C" tr -i $Mode --tu-budget=0 --verdict-cache=cache.json \
+        --annotation-manifest=manifest.json nested_macros.c
+    cmp nested_macros.c original.c
+    if [ -e cache.json ] || [ -e manifest.json ]; then
+        echo "tr $Mode wrote the verdict cache or the manifest after the budget ran out"
+        exit 1
+    fi
+done
+
+# Which expansions run out of a tiny expansion budget depends on the
+# machine, but the output must still compile
+"$CPP2C" tr --expansion-budget=1 nested_macros.c > tiny.c
+"$CLANG" -fsyntax-only tiny.c
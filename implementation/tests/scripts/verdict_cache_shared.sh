@@ -0,0 +1,49 @@
+#!/bin/bash
+# tests that translation units transformed in parallel with the same
+# verdict cache keep each other's verdicts
+
+CPP2C=$1
+TESTS_DIR=$2
+
+set -e
+command -v python3 > /dev/null || exit 77
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$TESTS_DIR"/*.c "$TESTS_DIR"/*.h "$TMP" 2> /dev/null || true
+cd "$TMP"
+
+Files=(nested_macros.c bin_expr.c constants.c float_literals.c)
+
+# The verdicts each file caches on its own
+for File in "${Files[@]}"; do
+    "$CPP2C" tr --verdict-cache="$File.cache" "$File" > /dev/null
+done
+
+# The same files, all saving to one cache at once
+Pids=()
+for File in "${Files[@]}"; do
+    "$CPP2C" tr --verdict-cache=shared.cache "$File" > /dev/null &
+    Pids+=($!)
+done
+for Pid in "${Pids[@]}"; do
+    wait "$Pid"
+done
+
+python3 - shared.cache "${Files[@]/%/.cache}" <<'EOF'
+import json
+import os
+import sys
+
+with open(sys.argv[1]) as fp:
+    shared = json.load(fp)
+for path in sys.argv[2:]:
+    # Files with no expansions to check cache nothing
+    if not os.path.exists(path):
+        continue
+    with open(path) as fp:
+        own = json.load(fp)
+    missing = own.keys() - shared.keys()
+    if missing:
+        print(f'the shared cache lost the verdicts of {path}: {sorted(missing)}')
+        sys.exit(1)
+EOF